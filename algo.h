@@ -5,6 +5,64 @@
 #ifndef ALGORITHM_H_INCLUDED
 #define ALGORITHM_H_INCLUDED
 
+#include "instrument.h"
+#include "utility.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//  Non-modifying sequence operations:
+////////////////////////////////////////////////////////////////////////////////
+
+// The versions for raw int, unsigned and float pointers are overloaded with
+// SIMD kernels below; pass vector::data() to get them.
+
+template <class InputIterator, class T>
+InputIterator find(InputIterator first, InputIterator last, const T& val) {
+  for (; first != last; ++first)
+    if (*first == val) break;
+  return first;
+}
+
+template <class InputIterator, class T>
+int count(InputIterator first, InputIterator last, const T& val) {
+  int n = 0;
+  for (; first != last; ++first)
+    if (*first == val) n++;
+  return n;
+}
+
+template <class InputIterator1, class InputIterator2>
+int equal(InputIterator1 first1, InputIterator1 last1,
+          InputIterator2 first2) {
+  for (; first1 != last1; ++first1, ++first2)
+    if (!(*first1 == *first2)) return 0;
+  return 1;
+}
+
+template <class InputIterator1, class InputIterator2, class BinaryPredicate>
+int equal(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2,
+          BinaryPredicate pred) {
+  for (; first1 != last1; ++first1, ++first2)
+    if (!pred(*first1, *first2)) return 0;
+  return 1;
+}
+
+template <class InputIterator, class T>
+T accumulate(InputIterator first, InputIterator last, T init) {
+  for (; first != last; ++first) init = init + *first;
+  return init;
+}
+
+template <class InputIterator, class T, class BinaryOperation>
+T accumulate(InputIterator first, InputIterator last, T init,
+             BinaryOperation op) {
+  for (; first != last; ++first) init = op(init, *first);
+  return init;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Modifying sequence operations:
 ////////////////////////////////////////////////////////////////////////////////
@@ -30,113 +88,712 @@ const T& max(const T& a, const T& b) {
   return a < b ? b : a;
 }
 
+// Both return the first of several equal extremes, and last for an empty
+// range.
+template <class ForwardIterator>
+ForwardIterator min_element(ForwardIterator first, ForwardIterator last) {
+  ForwardIterator best = first;
+  if (first == last) return best;
+  for (++first; first != last; ++first)
+    if (*first < *best) best = first;
+  return best;
+}
+
+template <class ForwardIterator, class Compare>
+ForwardIterator min_element(ForwardIterator first, ForwardIterator last,
+                            Compare comp) {
+  ForwardIterator best = first;
+  if (first == last) return best;
+  for (++first; first != last; ++first)
+    if (comp(*first, *best)) best = first;
+  return best;
+}
+
+template <class ForwardIterator>
+ForwardIterator max_element(ForwardIterator first, ForwardIterator last) {
+  ForwardIterator best = first;
+  if (first == last) return best;
+  for (++first; first != last; ++first)
+    if (*best < *first) best = first;
+  return best;
+}
+
+template <class ForwardIterator, class Compare>
+ForwardIterator max_element(ForwardIterator first, ForwardIterator last,
+                            Compare comp) {
+  ForwardIterator best = first;
+  if (first == last) return best;
+  for (++first; first != last; ++first)
+    if (comp(*best, *first)) best = first;
+  return best;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Heap:
 ////////////////////////////////////////////////////////////////////////////////
 
+// The helpers are defined at the end of the file. Without these declarations
+// they would be found only by argument-dependent lookup, which finds nothing
+// when the iterators are raw pointers and there is no comparator.
+template <class RandomAccessIterator, class T>
+void _heap_hole_up(RandomAccessIterator first, int idx, T val);
+template <class RandomAccessIterator, class T, class Compare>
+void _heap_hole_up(RandomAccessIterator first, int idx, T val, Compare comp);
+template <class RandomAccessIterator, class T>
+void _heap_hole_down(RandomAccessIterator first, int n, int idx, T val);
+template <class RandomAccessIterator, class T, class Compare>
+void _heap_hole_down(RandomAccessIterator first, int n, int idx, T val,
+                     Compare comp);
+template <class RandomAccessIterator, class T>
+void _heap_pop(RandomAccessIterator first, int n, T val);
+template <class RandomAccessIterator, class T, class Compare>
+void _heap_pop(RandomAccessIterator first, int n, T val, Compare comp);
+
 template <class RandomAccessIterator>
 void push_heap(RandomAccessIterator first, RandomAccessIterator last) {
-  _heap_percolate_up(first, last - first - 1);
+  int idx = last - first - 1;
+  if (idx > 0) _heap_hole_up(first, idx, first[idx]);
 }
 
 template <class RandomAccessIterator, class Compare>
 void push_heap(RandomAccessIterator first, RandomAccessIterator last,
                Compare comp) {
-  _heap_percolate_up(first, last - first - 1, comp);
+  int idx = last - first - 1;
+  if (idx > 0) _heap_hole_up(first, idx, first[idx], comp);
 }
 
 template <class RandomAccessIterator>
 void pop_heap(RandomAccessIterator first, RandomAccessIterator last) {
   int n = last - first;
-  swap(first[0], first[n - 1]);
-  _heap_percolate_down(first, n - 1, 0);
+  if (n > 1) _heap_pop(first, n, first[n - 1]);
 }
 
 template <class RandomAccessIterator, class Compare>
 void pop_heap(RandomAccessIterator first, RandomAccessIterator last,
               Compare comp) {
   int n = last - first;
-  swap(first[0], first[n - 1]);
-  _heap_percolate_down(first, n - 1, 0, comp);
+  if (n > 1) _heap_pop(first, n, first[n - 1], comp);
 }
 
 template <class RandomAccessIterator>
 void make_heap(RandomAccessIterator first, RandomAccessIterator last) {
   int n = last - first;
-  for (int i = n / 2; i >= 0; i--) _heap_percolate_down(first, n, i);
+  for (int i = n / 2 - 1; i >= 0; i--) _heap_hole_down(first, n, i, first[i]);
 }
 
 template <class RandomAccessIterator, class Compare>
 void make_heap(RandomAccessIterator first, RandomAccessIterator last,
                Compare comp) {
   int n = last - first;
-  for (int i = n / 2; i >= 0; i--) _heap_percolate_down(first, n, i, comp);
+  for (int i = n / 2 - 1; i >= 0; i--)
+    _heap_hole_down(first, n, i, first[i], comp);
+}
+
+// The heaps are min-heaps, so popping them one by one leaves the range in
+// descending order. heap_sort() below sorts ascending.
+template <class RandomAccessIterator>
+void sort_heap(RandomAccessIterator first, RandomAccessIterator last) {
+  for (; last - first > 1; --last) pop_heap(first, last);
 }
 
+template <class RandomAccessIterator, class Compare>
+void sort_heap(RandomAccessIterator first, RandomAccessIterator last,
+               Compare comp) {
+  for (; last - first > 1; --last) pop_heap(first, last, comp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Sorting:
+////////////////////////////////////////////////////////////////////////////////
+
+// The sorts order the range ascending by operator< or by comp. The versions
+// without comp forward to the others with _less, and all of them get the
+// value type from the &*first pointer, as BCC has no iterator traits.
+
+template <class T>
+struct _less {
+  int operator()(const T& lhs, const T& rhs) const { return lhs < rhs; }
+};
+
+template <class T>
+_less<T> _less_for(const T*) {
+  return _less<T>();
+}
+
+// Introsort: quicksort on median-of-three pivots that falls back to heapsort
+// when the recursion gets too deep, leaving short runs to a final insertion
+// sort. O(n log n) worst case, not stable.
+template <class RandomAccessIterator>
+void sort(RandomAccessIterator first, RandomAccessIterator last) {
+  if (last - first > 1) sort(first, last, _less_for(&*first));
+}
+
+template <class RandomAccessIterator, class Compare>
+void sort(RandomAccessIterator first, RandomAccessIterator last,
+          Compare comp) {
+  int n = last - first;
+  if (n < 2) return;
+  int depth = 0;
+  for (int i = n; i > 1; i >>= 1) depth += 2;
+  _introsort(first, n, depth, comp, &*first);
+  _insertion_sort(first, n, comp, &*first);
+}
+
+// In-place heapsort through a heap ordered the other way round. O(n log n)
+// worst case, not stable.
+template <class RandomAccessIterator>
+void heap_sort(RandomAccessIterator first, RandomAccessIterator last) {
+  if (last - first > 1) heap_sort(first, last, _less_for(&*first));
+}
+
+template <class RandomAccessIterator, class Compare>
+void heap_sort(RandomAccessIterator first, RandomAccessIterator last,
+               Compare comp) {
+  if (last - first > 1) _heap_sort(first, last - first, comp, &*first);
+}
+
+// Merge sort: elements that compare equal keep their relative order. Takes a
+// buffer of half the range.
+template <class RandomAccessIterator>
+void stable_sort(RandomAccessIterator first, RandomAccessIterator last) {
+  if (last - first > 1) stable_sort(first, last, _less_for(&*first));
+}
+
+template <class RandomAccessIterator, class Compare>
+void stable_sort(RandomAccessIterator first, RandomAccessIterator last,
+                 Compare comp) {
+  int n = last - first;
+  if (n > 1) _stable_sort(first, n, comp, &*first);
+}
+
+// Puts the smallest middle - first elements, sorted, in [first, middle). The
+// rest end up in [middle, last) in no particular order. O(n log k) for k
+// sorted elements.
+template <class RandomAccessIterator>
+void partial_sort(RandomAccessIterator first, RandomAccessIterator middle,
+                  RandomAccessIterator last) {
+  if (middle - first > 0)
+    partial_sort(first, middle, last, _less_for(&*first));
+}
+
+template <class RandomAccessIterator, class Compare>
+void partial_sort(RandomAccessIterator first, RandomAccessIterator middle,
+                  RandomAccessIterator last, Compare comp) {
+  if (middle - first > 0)
+    _partial_sort(first, middle - first, last - first, comp, &*first);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  SSE2 kernels:
+////////////////////////////////////////////////////////////////////////////////
+
+// Overloads of the sequence operations for raw int, unsigned and float
+// ranges that test four elements per instruction. They return exactly what
+// the generic versions would: the float ones compare with == and < as the
+// scalar loops do, NaNs included. accumulate over floats stays generic, as
+// adding in another order would change the rounding. Unsigned ranges share
+// the int kernels wherever only the bits matter.
+
+#if defined(__SSE2__)
+
+inline __m128i _sse_load(const int* p) {
+  return _mm_loadu_si128((const __m128i*)p);
+}
+
+inline int _lowest_bit(int mask) {
+  int i = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+}
+
+inline const int* find(const int* first, const int* last, int val) {
+  __m128i v = _mm_set1_epi32(val);
+  for (; last - first >= 4; first += 4) {
+    __m128i eq = _mm_cmpeq_epi32(_sse_load(first), v);
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+    if (mask) return first + _lowest_bit(mask);
+  }
+  for (; first != last; ++first)
+    if (*first == val) break;
+  return first;
+}
+
+inline const unsigned* find(const unsigned* first, const unsigned* last,
+                            unsigned val) {
+  return (const unsigned*)find((const int*)first, (const int*)last, (int)val);
+}
+
+inline const float* find(const float* first, const float* last, float val) {
+  __m128 v = _mm_set1_ps(val);
+  for (; last - first >= 4; first += 4) {
+    int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(first), v));
+    if (mask) return first + _lowest_bit(mask);
+  }
+  for (; first != last; ++first)
+    if (*first == val) break;
+  return first;
+}
+
+// Each lane subtracts its all-ones matches, counting up to 2^31 apiece.
+inline int count(const int* first, const int* last, int val) {
+  __m128i v = _mm_set1_epi32(val);
+  __m128i acc = _mm_setzero_si128();
+  for (; last - first >= 4; first += 4)
+    acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(_sse_load(first), v));
+  int lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, acc);
+  int n = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for (; first != last; ++first)
+    if (*first == val) n++;
+  return n;
+}
+
+inline int count(const unsigned* first, const unsigned* last, unsigned val) {
+  return count((const int*)first, (const int*)last, (int)val);
+}
+
+inline int count(const float* first, const float* last, float val) {
+  __m128 v = _mm_set1_ps(val);
+  __m128i acc = _mm_setzero_si128();
+  for (; last - first >= 4; first += 4) {
+    __m128 eq = _mm_cmpeq_ps(_mm_loadu_ps(first), v);
+    acc = _mm_sub_epi32(acc, _mm_castps_si128(eq));
+  }
+  int lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, acc);
+  int n = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for (; first != last; ++first)
+    if (*first == val) n++;
+  return n;
+}
+
+inline int equal(const int* first1, const int* last1, const int* first2) {
+  for (; last1 - first1 >= 4; first1 += 4, first2 += 4) {
+    __m128i eq = _mm_cmpeq_epi32(_sse_load(first1), _sse_load(first2));
+    if (_mm_movemask_epi8(eq) != 0xffff) return 0;
+  }
+  for (; first1 != last1; ++first1, ++first2)
+    if (*first1 != *first2) return 0;
+  return 1;
+}
+
+inline int equal(const unsigned* first1, const unsigned* last1,
+                 const unsigned* first2) {
+  return equal((const int*)first1, (const int*)last1, (const int*)first2);
+}
+
+inline int equal(const float* first1, const float* last1,
+                 const float* first2) {
+  for (; last1 - first1 >= 4; first1 += 4, first2 += 4) {
+    __m128 eq = _mm_cmpeq_ps(_mm_loadu_ps(first1), _mm_loadu_ps(first2));
+    if (_mm_movemask_ps(eq) != 0xf) return 0;
+  }
+  for (; first1 != last1; ++first1, ++first2)
+    if (!(*first1 == *first2)) return 0;
+  return 1;
+}
+
+// Wraps around on overflow like the scalar sum in two's complement.
+inline int accumulate(const int* first, const int* last, int init) {
+  __m128i acc = _mm_setzero_si128();
+  for (; last - first >= 4; first += 4)
+    acc = _mm_add_epi32(acc, _sse_load(first));
+  int lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, acc);
+  unsigned sum = (unsigned)init + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for (; first != last; ++first) sum += *first;
+  return (int)sum;
+}
+
+inline unsigned accumulate(const unsigned* first, const unsigned* last,
+                           unsigned init) {
+  return (unsigned)accumulate((const int*)first, (const int*)last, (int)init);
+}
+
+// The extremes find the extreme value first and then its first position.
+// Unsigned lanes are compared as signed after flipping the top bit, which
+// SSE2 lacks a compare for.
+inline int _sse_extreme(const int* first, const int* last, unsigned bias,
+                        int want_max) {
+  __m128i b = _mm_set1_epi32((int)bias);
+  __m128i m = _mm_xor_si128(_mm_set1_epi32(*first), b);
+  for (; last - first >= 4; first += 4) {
+    __m128i x = _mm_xor_si128(_sse_load(first), b);
+    __m128i take = want_max ? _mm_cmpgt_epi32(x, m) : _mm_cmplt_epi32(x, m);
+    m = _mm_or_si128(_mm_and_si128(take, x), _mm_andnot_si128(take, m));
+  }
+  int lanes[4];
+  _mm_storeu_si128((__m128i*)lanes, m);
+  int best = lanes[0];
+  for (int i = 1; i < 4; i++)
+    if (want_max ? lanes[i] > best : lanes[i] < best) best = lanes[i];
+  for (; first != last; ++first) {
+    int x = *first ^ (int)bias;
+    if (want_max ? x > best : x < best) best = x;
+  }
+  return best ^ (int)bias;
+}
+
+inline const int* min_element(const int* first, const int* last) {
+  if (first == last) return last;
+  return find(first, last, _sse_extreme(first, last, 0, 0));
+}
+
+inline const int* max_element(const int* first, const int* last) {
+  if (first == last) return last;
+  return find(first, last, _sse_extreme(first, last, 0, 1));
+}
+
+inline const unsigned* min_element(const unsigned* first,
+                                   const unsigned* last) {
+  if (first == last) return last;
+  int val = _sse_extreme((const int*)first, (const int*)last, 0x80000000u, 0);
+  return find(first, last, (unsigned)val);
+}
+
+inline const unsigned* max_element(const unsigned* first,
+                                   const unsigned* last) {
+  if (first == last) return last;
+  int val = _sse_extreme((const int*)first, (const int*)last, 0x80000000u, 1);
+  return find(first, last, (unsigned)val);
+}
+
+// minps and maxps return their second operand when either is a NaN, so
+// keeping the running extreme second skips NaNs the way the scalar < does.
+// A NaN in front compares false against everything and is the answer.
+inline float _sse_extreme(const float* first, const float* last,
+                          int want_max) {
+  __m128 m = _mm_set1_ps(*first);
+  for (; last - first >= 4; first += 4) {
+    __m128 x = _mm_loadu_ps(first);
+    m = want_max ? _mm_max_ps(x, m) : _mm_min_ps(x, m);
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, m);
+  float best = lanes[0];
+  for (int i = 1; i < 4; i++)
+    if (want_max ? best < lanes[i] : lanes[i] < best) best = lanes[i];
+  for (; first != last; ++first)
+    if (want_max ? best < *first : *first < best) best = *first;
+  return best;
+}
+
+inline const float* min_element(const float* first, const float* last) {
+  if (first == last || *first != *first) return first;
+  return find(first, last, _sse_extreme(first, last, 0));
+}
+
+inline const float* max_element(const float* first, const float* last) {
+  if (first == last || *first != *first) return first;
+  return find(first, last, _sse_extreme(first, last, 1));
+}
+
+// Without these, calls on non-const pointers would pick the generic
+// templates, which match them without a qualification conversion.
+inline int* find(int* first, int* last, int val) {
+  return (int*)find((const int*)first, (const int*)last, val);
+}
+
+inline unsigned* find(unsigned* first, unsigned* last, unsigned val) {
+  return (unsigned*)find((const unsigned*)first, (const unsigned*)last, val);
+}
+
+inline float* find(float* first, float* last, float val) {
+  return (float*)find((const float*)first, (const float*)last, val);
+}
+
+inline int count(int* first, int* last, int val) {
+  return count((const int*)first, (const int*)last, val);
+}
+
+inline int count(unsigned* first, unsigned* last, unsigned val) {
+  return count((const unsigned*)first, (const unsigned*)last, val);
+}
+
+inline int count(float* first, float* last, float val) {
+  return count((const float*)first, (const float*)last, val);
+}
+
+inline int equal(int* first1, int* last1, int* first2) {
+  return equal((const int*)first1, (const int*)last1, (const int*)first2);
+}
+
+inline int equal(unsigned* first1, unsigned* last1, unsigned* first2) {
+  return equal((const unsigned*)first1, (const unsigned*)last1,
+               (const unsigned*)first2);
+}
+
+inline int equal(float* first1, float* last1, float* first2) {
+  return equal((const float*)first1, (const float*)last1,
+               (const float*)first2);
+}
+
+inline int accumulate(int* first, int* last, int init) {
+  return accumulate((const int*)first, (const int*)last, init);
+}
+
+inline unsigned accumulate(unsigned* first, unsigned* last, unsigned init) {
+  return accumulate((const unsigned*)first, (const unsigned*)last, init);
+}
+
+inline int* min_element(int* first, int* last) {
+  return (int*)min_element((const int*)first, (const int*)last);
+}
+
+inline int* max_element(int* first, int* last) {
+  return (int*)max_element((const int*)first, (const int*)last);
+}
+
+inline unsigned* min_element(unsigned* first, unsigned* last) {
+  return (unsigned*)min_element((const unsigned*)first, (const unsigned*)last);
+}
+
+inline unsigned* max_element(unsigned* first, unsigned* last) {
+  return (unsigned*)max_element((const unsigned*)first, (const unsigned*)last);
+}
+
+inline float* min_element(float* first, float* last) {
+  return (float*)min_element((const float*)first, (const float*)last);
+}
+
+inline float* max_element(float* first, float* last) {
+  return (float*)max_element((const float*)first, (const float*)last);
+}
+
+#endif  // __SSE2__
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Helper functions
 ////////////////////////////////////////////////////////////////////////////////
 
+// The percolations move a hole instead of swapping: the displaced value is
+// held in a local and written once at its final position, so each level costs
+// one copy instead of the three done by swap. With STL_INSTRUMENT the copies
+// are counted as heap moves, along with every comparison.
+
 template <class RandomAccessIterator>
 int _heap_min_child_idx(RandomAccessIterator first, int n, int idx) {
   int l = idx * 2 + 1;
-  int r = (idx + 1) * 2;
-  if (l >= n && r >= n) return -1;
-  if (l >= n) return r;
-  if (r >= n) return l;
-  return (first[r] < first[l]) ? r : l;
+  if (l >= n) return -1;
+  if (l + 1 == n) return l;
+  _STL_COUNT_TOTAL(stats_heap, compares, 1);
+  return (first[l + 1] < first[l]) ? l + 1 : l;
 }
 
 template <class RandomAccessIterator, class Compare>
 int _heap_min_child_idx(RandomAccessIterator first, int n, int idx,
                         Compare comp) {
   int l = idx * 2 + 1;
-  int r = (idx + 1) * 2;
-  if (l >= n && r >= n) return -1;
-  if (l >= n) return r;
-  if (r >= n) return l;
-  return (comp(first[r], first[l])) ? r : l;
+  if (l >= n) return -1;
+  if (l + 1 == n) return l;
+  _STL_COUNT_TOTAL(stats_heap, compares, 1);
+  return (comp(first[l + 1], first[l])) ? l + 1 : l;
 }
 
-template <class RandomAccessIterator>
-void _heap_percolate_up(RandomAccessIterator first, int idx) {
+// val is taken by value: it is the element being moved out of the hole.
+template <class RandomAccessIterator, class T>
+void _heap_hole_up(RandomAccessIterator first, int idx, T val) {
   int p = (idx - 1) / 2;
-  while (idx && first[idx] < first[p]) {
-    swap(first[p], first[idx]);
+  while (idx && val < first[p]) {
+    _STL_COUNT_TOTAL(stats_heap, compares, 1);
+    _STL_COUNT_TOTAL(stats_heap, moves, 1);
+    first[idx] = first[p];
     idx = p;
     p = (idx - 1) / 2;
   }
+  // The comparison that ended the loop, unless it reached the root.
+  _STL_COUNT_TOTAL(stats_heap, compares, idx != 0);
+  _STL_COUNT_TOTAL(stats_heap, moves, 1);
+  first[idx] = val;
 }
 
-template <class RandomAccessIterator, class Compare>
-void _heap_percolate_up(RandomAccessIterator first, int idx, Compare comp) {
+template <class RandomAccessIterator, class T, class Compare>
+void _heap_hole_up(RandomAccessIterator first, int idx, T val, Compare comp) {
   int p = (idx - 1) / 2;
-  while (idx && comp(first[idx], first[p])) {
-    swap(first[p], first[idx]);
+  while (idx && comp(val, first[p])) {
+    _STL_COUNT_TOTAL(stats_heap, compares, 1);
+    _STL_COUNT_TOTAL(stats_heap, moves, 1);
+    first[idx] = first[p];
     idx = p;
     p = (idx - 1) / 2;
   }
+  _STL_COUNT_TOTAL(stats_heap, compares, idx != 0);
+  _STL_COUNT_TOTAL(stats_heap, moves, 1);
+  first[idx] = val;
 }
 
-template <class RandomAccessIterator>
-void _heap_percolate_down(RandomAccessIterator first, int n, int idx) {
+template <class RandomAccessIterator, class T>
+void _heap_hole_down(RandomAccessIterator first, int n, int idx, T val) {
   int c = _heap_min_child_idx(first, n, idx);
-  while (c != -1 && first[c] < first[idx]) {
-    swap(first[c], first[idx]);
+  while (c != -1 && first[c] < val) {
+    _STL_COUNT_TOTAL(stats_heap, compares, 1);
+    _STL_COUNT_TOTAL(stats_heap, moves, 1);
+    first[idx] = first[c];
     idx = c;
     c = _heap_min_child_idx(first, n, idx);
   }
+  // The comparison that ended the loop, unless it reached a leaf.
+  _STL_COUNT_TOTAL(stats_heap, compares, c != -1);
+  _STL_COUNT_TOTAL(stats_heap, moves, 1);
+  first[idx] = val;
 }
 
-template <class RandomAccessIterator, class Compare>
-void _heap_percolate_down(RandomAccessIterator first, int n, int idx,
-                          Compare comp) {
+template <class RandomAccessIterator, class T, class Compare>
+void _heap_hole_down(RandomAccessIterator first, int n, int idx, T val,
+                     Compare comp) {
   int c = _heap_min_child_idx(first, n, idx, comp);
-  while (c != -1 && comp(first[c], first[idx])) {
-    swap(first[c], first[idx]);
+  while (c != -1 && comp(first[c], val)) {
+    _STL_COUNT_TOTAL(stats_heap, compares, 1);
+    _STL_COUNT_TOTAL(stats_heap, moves, 1);
+    first[idx] = first[c];
     idx = c;
     c = _heap_min_child_idx(first, n, idx, comp);
   }
+  _STL_COUNT_TOTAL(stats_heap, compares, c != -1);
+  _STL_COUNT_TOTAL(stats_heap, moves, 1);
+  first[idx] = val;
+}
+
+// Moves the top to the back slot and sifts the old back element, val, down
+// from the root of the remaining n - 1 elements.
+template <class RandomAccessIterator, class T>
+void _heap_pop(RandomAccessIterator first, int n, T val) {
+  _STL_COUNT_TOTAL(stats_heap, moves, 1);
+  first[n - 1] = first[0];
+  _heap_hole_down(first, n - 1, 0, val);
+}
+
+template <class RandomAccessIterator, class T, class Compare>
+void _heap_pop(RandomAccessIterator first, int n, T val, Compare comp) {
+  _STL_COUNT_TOTAL(stats_heap, moves, 1);
+  first[n - 1] = first[0];
+  _heap_hole_down(first, n - 1, 0, val, comp);
+}
+
+// Swaps the arguments of comp, so that the min-heap routines build max-heaps.
+template <class Compare, class T>
+struct _reverse_compare {
+  Compare comp;
+  _reverse_compare(Compare comp) : comp(comp) {}
+  int operator()(const T& lhs, const T& rhs) { return comp(rhs, lhs); }
+};
+
+// Short runs sort faster by insertion than by further partitioning.
+const int _kSortThreshold = 16;
+
+template <class RandomAccessIterator, class Compare, class T>
+void _insertion_sort(RandomAccessIterator first, int n, Compare comp, T*) {
+  for (int i = 1; i < n; i++) {
+    if (!comp(first[i], first[i - 1])) continue;
+    T val = first[i];
+    int j = i;
+    do {
+      first[j] = first[j - 1];
+      j--;
+    } while (j && comp(val, first[j - 1]));
+    first[j] = val;
+  }
+}
+
+// Partitions until the runs are short, recursing into the smaller part and
+// looping on the larger one, so the stack stays O(log n) deep.
+template <class RandomAccessIterator, class Compare, class T>
+void _introsort(RandomAccessIterator first, int n, int depth, Compare comp,
+                T* tag) {
+  while (n > _kSortThreshold) {
+    if (!depth--) {
+      _heap_sort(first, n, comp, tag);
+      return;
+    }
+    // The median of three goes to the front, and Hoare's scheme around the
+    // front value leaves both parts nonempty.
+    int mid = n / 2;
+    if (comp(first[mid], first[1])) swap(first[mid], first[1]);
+    if (comp(first[n - 1], first[mid])) {
+      swap(first[n - 1], first[mid]);
+      if (comp(first[mid], first[1])) swap(first[mid], first[1]);
+    }
+    swap(first[0], first[mid]);
+    T pivot = first[0];
+    int i = -1, j = n;
+    for (;;) {
+      while (comp(first[++i], pivot)) {
+      }
+      while (comp(pivot, first[--j])) {
+      }
+      if (i >= j) break;
+      swap(first[i], first[j]);
+    }
+    int left = j + 1;
+    if (left < n - left) {
+      _introsort(first, left, depth, comp, tag);
+      first += left;
+      n -= left;
+    } else {
+      _introsort(first + left, n - left, depth, comp, tag);
+      n = left;
+    }
+  }
+}
+
+template <class RandomAccessIterator, class Compare, class T>
+void _heap_sort(RandomAccessIterator first, int n, Compare comp, T*) {
+  _reverse_compare<Compare, T> greater(comp);
+  make_heap(first, first + n, greater);
+  sort_heap(first, first + n, greater);
+}
+
+template <class RandomAccessIterator, class Compare, class T>
+void _stable_sort(RandomAccessIterator first, int n, Compare comp, T* tag) {
+  int half = n / 2;
+  T* buf = _allocate(half, (T*)0);
+  for (int i = 0; i < half; i++) _construct(buf + i, first[i]);
+  _merge_sort(first, n, buf, comp, tag);
+  for (int i = 0; i < half; i++) _destroy(buf + i);
+  _deallocate(buf);
+}
+
+// Sorts both halves, then merges them back into place from a copy of the
+// left half in buf. Ties go to the left half, which keeps the sort stable.
+template <class RandomAccessIterator, class Compare, class T>
+void _merge_sort(RandomAccessIterator first, int n, T* buf, Compare comp,
+                 T* tag) {
+  if (n <= _kSortThreshold) {
+    _insertion_sort(first, n, comp, tag);
+    return;
+  }
+  int half = n / 2;
+  _merge_sort(first, half, buf, comp, tag);
+  _merge_sort(first + half, n - half, buf, comp, tag);
+  if (!comp(first[half], first[half - 1])) return;
+  for (int i = 0; i < half; i++) buf[i] = first[i];
+  int i = 0, j = half, k = 0;
+  while (i < half && j < n) {
+    if (comp(first[j], buf[i]))
+      first[k++] = first[j++];
+    else
+      first[k++] = buf[i++];
+  }
+  while (i < half) first[k++] = buf[i++];
+}
+
+// Keeps the k smallest seen so far in a max-heap at the front, replacing its
+// top whenever a smaller element turns up.
+template <class RandomAccessIterator, class Compare, class T>
+void _partial_sort(RandomAccessIterator first, int k, int n, Compare comp,
+                   T*) {
+  _reverse_compare<Compare, T> greater(comp);
+  make_heap(first, first + k, greater);
+  for (int i = k; i < n; i++) {
+    if (!comp(first[i], first[0])) continue;
+    T val = first[i];
+    first[i] = first[0];
+    _heap_hole_down(first, k, 0, val, greater);
+  }
+  sort_heap(first, first + k, greater);
 }
 
 #endif  // ALGORITHM_H_INCLUDED
@@ -0,0 +1,229 @@
+// File: allocator.h
+//
+// Description: Memory resources for the containers. BCC can't default a
+//              template parameter, so instead of an Allocator parameter
+//              vector, deque, list and map (and stack and queue on top of
+//              them) take an allocator& at construction and keep a pointer
+//              to it; without one they use global new and delete as before.
+//              flat_map takes one for its vector. btree_map and
+//              unordered_map always use global new. A copy allocates through
+//              the allocator of the container it copies; assignment keeps
+//              the allocator of the target.
+
+#ifndef _STL_ALLOCATOR_H_
+#define _STL_ALLOCATOR_H_
+
+#include <assert.h>
+
+// Every block handed out is aligned for any of these.
+union _max_align {
+  long l;
+  double d;
+  long double ld;
+  void* p;
+};
+
+inline unsigned _align_up(unsigned n) {
+  unsigned a = sizeof(_max_align);
+  return (n + a - 1) / a * a;
+}
+
+// deallocate() gets back the size that was passed to allocate(). The
+// allocator must outlive every container using it.
+class allocator {
+ public:
+  virtual ~allocator() {}
+  virtual void* allocate(unsigned bytes) = 0;
+  virtual void deallocate(void* p, unsigned bytes) = 0;
+
+  // Nonzero if deallocate() does nothing and memory only comes back when the
+  // allocator is released as a whole. Containers then clear elements that
+  // need no destructor in O(1), without visiting them.
+  virtual int is_monotonic() const { return 0; }
+};
+
+// The containers' allocation calls; a null allocator means global new and
+// delete, which keeps default-constructed containers free of virtual calls.
+inline void* _allocate_bytes(allocator* a, unsigned bytes) {
+  if (!bytes) return 0;
+  return a ? a->allocate(bytes) : ::operator new(bytes);
+}
+
+inline void _deallocate_bytes(allocator* a, void* p, unsigned bytes) {
+  if (!p) return;
+  if (a)
+    a->deallocate(p, bytes);
+  else
+    ::operator delete(p);
+}
+
+inline int _is_monotonic(allocator* a) { return a && a->is_monotonic(); }
+
+// Fixed-size blocks for list and map nodes, carved from chunks of
+// nodes_per_chunk blocks and recycled through a free list, so allocating and
+// freeing a node is O(1) and never reaches the heap once the chunks cover
+// the peak size. node_size is that of the container's nodes, as given by
+// list::node_size() or map::node_size(). Larger requests (such as the single
+// block of map::assign) fall through to global new; the size is never taken
+// from the first request, since that may be such a block.
+class node_pool : public allocator {
+ public:
+  node_pool(unsigned node_size, unsigned nodes_per_chunk = 64)
+      : size_(_align_up(node_size < sizeof(void*) ? sizeof(void*)
+                                                  : node_size)),
+        per_chunk_(nodes_per_chunk),
+        chunks_(0),
+        free_(0),
+        cur_(0),
+        left_(0) {
+    assert(node_size && per_chunk_);
+  }
+
+  ~node_pool() { release(); }
+
+  void* allocate(unsigned bytes) {
+    if (bytes > size_) return ::operator new(bytes);
+    if (free_) {
+      void* p = free_;
+      free_ = *(void**)free_;
+      return p;
+    }
+    if (!left_) add_chunk();
+    void* p = cur_;
+    cur_ += size_;
+    left_--;
+    return p;
+  }
+
+  void deallocate(void* p, unsigned bytes) {
+    if (bytes > size_) {
+      ::operator delete(p);
+      return;
+    }
+    *(void**)p = free_;
+    free_ = p;
+  }
+
+  // Frees every chunk at once. Blocks still in use become invalid, so the
+  // containers using the pool must be gone or cleared.
+  void release() {
+    while (chunks_) {
+      void* next = *(void**)chunks_;
+      ::operator delete(chunks_);
+      chunks_ = next;
+    }
+    free_ = 0;
+    cur_ = 0;
+    left_ = 0;
+  }
+
+  unsigned node_size() const { return size_; }
+
+ private:
+  unsigned size_, per_chunk_;
+  // Each chunk starts with a link to the previous one.
+  void* chunks_;
+  void* free_;
+  char* cur_;
+  unsigned left_;
+
+  void add_chunk() {
+    unsigned header = _align_up(sizeof(void*));
+    void* chunk = ::operator new(header + size_ * per_chunk_);
+    *(void**)chunk = chunks_;
+    chunks_ = chunk;
+    cur_ = (char*)chunk + header;
+    left_ = per_chunk_;
+  }
+
+  node_pool(const node_pool&);
+  node_pool& operator=(const node_pool&);
+};
+
+// Bump allocation from a buffer that is freed all at once: allocate() is a
+// pointer increment, deallocate() does nothing, and release() (or the
+// destructor) returns everything. Containers clear elements that need no
+// destructor without visiting them, so a per-request map or list is torn
+// down in O(1). Chunks double in size, so n bytes take O(log n) chunks.
+class monotonic_arena : public allocator {
+ public:
+  monotonic_arena(unsigned chunk_size = 4096)
+      : buf_(0),
+        buf_size_(0),
+        first_chunk_(chunk_size),
+        chunk_size_(chunk_size),
+        chunks_(0),
+        cur_(0),
+        used_(0),
+        cap_(0) {}
+
+  // Starts in the caller's buffer, which must be aligned like _max_align
+  // and is never freed. Only once it is full are chunks allocated.
+  monotonic_arena(void* buf, unsigned size, unsigned chunk_size = 4096)
+      : buf_((char*)buf),
+        buf_size_(size),
+        first_chunk_(chunk_size),
+        chunk_size_(chunk_size),
+        chunks_(0),
+        cur_((char*)buf),
+        used_(0),
+        cap_(size) {}
+
+  ~monotonic_arena() { release(); }
+
+  void* allocate(unsigned bytes) {
+    unsigned at = _align_up(used_);
+    if (at > cap_ || cap_ - at < bytes) {
+      add_chunk(bytes);
+      at = 0;
+    }
+    used_ = at + bytes;
+    return cur_ + at;
+  }
+
+  void deallocate(void*, unsigned) {}
+
+  int is_monotonic() const { return 1; }
+
+  // Frees the chunks and starts over in the caller's buffer, if any.
+  // Everything allocated so far becomes invalid.
+  void release() {
+    while (chunks_) {
+      void* next = *(void**)chunks_;
+      ::operator delete(chunks_);
+      chunks_ = next;
+    }
+    chunk_size_ = first_chunk_;
+    cur_ = buf_;
+    used_ = 0;
+    cap_ = buf_size_;
+  }
+
+ private:
+  char* buf_;
+  unsigned buf_size_;
+  unsigned first_chunk_, chunk_size_;
+  // Each chunk starts with a link to the previous one.
+  void* chunks_;
+  char* cur_;
+  unsigned used_, cap_;
+
+  void add_chunk(unsigned bytes) {
+    unsigned header = _align_up(sizeof(void*));
+    unsigned size = chunk_size_;
+    if (size < bytes) size = bytes;
+    void* chunk = ::operator new(header + size);
+    *(void**)chunk = chunks_;
+    chunks_ = chunk;
+    cur_ = (char*)chunk + header;
+    used_ = 0;
+    cap_ = size;
+    // Doubling would overflow unsigned, so keep the size from there on.
+    if (chunk_size_ + chunk_size_ > chunk_size_) chunk_size_ += chunk_size_;
+  }
+
+  monotonic_arena(const monotonic_arena&);
+  monotonic_arena& operator=(const monotonic_arena&);
+};
+
+#endif  // _STL_ALLOCATOR_H_
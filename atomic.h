@@ -0,0 +1,148 @@
+// File: atomic.h
+//
+// Description: The few atomic operations the lock-free containers need, on
+//              plain word-sized variables. GCC and Clang get their __atomic
+//              builtins. Under BCC the target is a single-core DOS machine:
+//              a 16-bit int is read or written in one instruction, and
+//              anything wider (long, far pointers) or any read-modify-write
+//              is made atomic by masking interrupts around it.
+
+#ifndef _STL_ATOMIC_H_
+#define _STL_ATOMIC_H_
+
+#if defined(__GNUC__)
+
+template <class T>
+T atomic_load_relaxed(const volatile T* p) {
+  return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+// Later reads and writes can't move before an acquire load, and it sees
+// everything written before the release store that it reads from.
+template <class T>
+T atomic_load_acquire(const volatile T* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template <class T>
+void atomic_store_relaxed(volatile T* p, T val) {
+  __atomic_store_n(p, val, __ATOMIC_RELAXED);
+}
+
+template <class T>
+void atomic_store_release(volatile T* p, T val) {
+  __atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+// Sets *p to desired if it holds expected and returns nonzero; otherwise
+// loads *p into expected and returns 0. Sequentially consistent.
+template <class T>
+int atomic_compare_exchange(volatile T* p, T& expected, T desired) {
+  return __atomic_compare_exchange_n(p, &expected, desired, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+// Adds delta to *p and returns the old value. Sequentially consistent.
+template <class T>
+T atomic_fetch_add(volatile T* p, T delta) {
+  return __atomic_fetch_add(p, delta, __ATOMIC_SEQ_CST);
+}
+
+// A full barrier, ordering the stores before it against the loads after it.
+inline void atomic_fence() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+// Tells the core it is in a spin-wait loop.
+inline void cpu_relax() {
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#endif
+}
+
+#elif defined(__BORLANDC__)
+
+// One core, so volatile accesses are enough to order loads and stores against
+// interrupt handlers; only the compiler has to be kept from caching them.
+// pushf/popf restore the interrupt flag as it was, so the masked sections
+// also work inside interrupt handlers.
+
+// A long or a far pointer takes two 16-bit moves, and an interrupt between
+// them would see half of the old value and half of the new one.
+template <class T>
+T atomic_load_relaxed(const volatile T* p) {
+  T val;
+  asm pushf;
+  asm cli;
+  val = *p;
+  asm popf;
+  return val;
+}
+
+template <class T>
+T atomic_load_acquire(const volatile T* p) {
+  return atomic_load_relaxed(p);
+}
+
+template <class T>
+void atomic_store_relaxed(volatile T* p, T val) {
+  asm pushf;
+  asm cli;
+  *p = val;
+  asm popf;
+}
+
+template <class T>
+void atomic_store_release(volatile T* p, T val) {
+  atomic_store_relaxed(p, val);
+}
+
+// int and unsigned are a single word and need no masking.
+inline int atomic_load_relaxed(const volatile int* p) { return *p; }
+inline int atomic_load_acquire(const volatile int* p) { return *p; }
+inline void atomic_store_relaxed(volatile int* p, int val) { *p = val; }
+inline void atomic_store_release(volatile int* p, int val) { *p = val; }
+
+inline unsigned atomic_load_relaxed(const volatile unsigned* p) { return *p; }
+inline unsigned atomic_load_acquire(const volatile unsigned* p) { return *p; }
+inline void atomic_store_relaxed(volatile unsigned* p, unsigned val) {
+  *p = val;
+}
+inline void atomic_store_release(volatile unsigned* p, unsigned val) {
+  *p = val;
+}
+
+template <class T>
+int atomic_compare_exchange(volatile T* p, T& expected, T desired) {
+  int ok;
+  asm pushf;
+  asm cli;
+  if (*p == expected) {
+    *p = desired;
+    ok = 1;
+  } else {
+    expected = *p;
+    ok = 0;
+  }
+  asm popf;
+  return ok;
+}
+
+template <class T>
+T atomic_fetch_add(volatile T* p, T delta) {
+  T old;
+  asm pushf;
+  asm cli;
+  old = *p;
+  *p = old + delta;
+  asm popf;
+  return old;
+}
+
+inline void atomic_fence() {}
+
+inline void cpu_relax() {}
+
+#else
+#error "atomic.h: no atomic operations for this compiler"
+#endif
+
+#endif  // _STL_ATOMIC_H_
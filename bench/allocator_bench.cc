@@ -0,0 +1,84 @@
+// File: bench/allocator_bench.cc
+//
+// Description: list and map built and torn down with global new, a
+//              node_pool and a monotonic_arena. The pool is kept between
+//              passes, so after the warm-up its chunks already cover the
+//              peak; the arena is released after each pass. churn erases
+//              and reinserts every key of a map that stays allocated.
+
+#include "harness.h"
+
+#include "allocator.h"
+#include "list.h"
+#include "map.h"
+
+namespace {
+
+// kKind picks global new (0), the node_pool (1) or the arena (2); the
+// containers for the others stay empty.
+template <int kKind>
+unsigned long list_build(unsigned n) {
+  static node_pool pool(list<unsigned>::node_size(), 256);
+  static monotonic_arena arena;
+  {
+    list<unsigned> l;
+    list<unsigned> pl(pool);
+    list<unsigned> al(arena);
+    list<unsigned>& use = kKind == 0 ? l : kKind == 1 ? pl : al;
+    for (unsigned i = 0; i < n; i++) use.push_back(i);
+    bench_sink(use.size());
+  }
+  arena.release();
+  return n;
+}
+
+template <int kKind>
+unsigned long map_build(unsigned n) {
+  static node_pool pool(map<unsigned, unsigned>::node_size(), 256);
+  static monotonic_arena arena;
+  const unsigned* keys = bench_keys(n);
+  {
+    map<unsigned, unsigned> m;
+    map<unsigned, unsigned> pm(pool);
+    map<unsigned, unsigned> am(arena);
+    map<unsigned, unsigned>& use = kKind == 0 ? m : kKind == 1 ? pm : am;
+    for (unsigned i = 0; i < n; i++) use.insert(keys[i], i);
+    bench_sink(use.size());
+  }
+  arena.release();
+  return n;
+}
+
+template <int kKind>
+unsigned long map_churn(unsigned n) {
+  static node_pool pool(map<unsigned, unsigned>::node_size(), 256);
+  static map<unsigned, unsigned>* m = 0;
+  static unsigned size = 0;
+  const unsigned* keys = bench_keys(n);
+  if (size != n) {
+    delete m;
+    m = kKind ? new map<unsigned, unsigned>(pool)
+              : new map<unsigned, unsigned>();
+    for (unsigned i = 0; i < n; i++) m->insert(keys[i], i);
+    size = n;
+  }
+  for (unsigned i = 0; i < n; i++) {
+    m->erase(keys[i]);
+    m->insert(keys[i], i);
+  }
+  bench_sink(m->size());
+  return n;
+}
+
+const unsigned kLarge = 1u << 20;
+
+}  // namespace
+
+STL_BENCH("allocator", "list_build", "new", kLarge, list_build<0>);
+STL_BENCH("allocator", "list_build", "node_pool", kLarge, list_build<1>);
+STL_BENCH("allocator", "list_build", "arena", kLarge, list_build<2>);
+STL_BENCH("allocator", "map_build", "new", kLarge, map_build<0>);
+STL_BENCH("allocator", "map_build", "node_pool", kLarge, map_build<1>);
+STL_BENCH("allocator", "map_build", "arena", kLarge, map_build<2>);
+STL_BENCH("allocator", "map_churn", "new", kLarge, map_churn<0>);
+STL_BENCH("allocator", "map_churn", "node_pool", kLarge, map_churn<1>);
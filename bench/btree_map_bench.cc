@@ -0,0 +1,70 @@
+// File: bench/btree_map_bench.cc
+//
+// Description: btree_map against the red-black map and std::map on random
+//              lookups, in-order scans, random inserts and a mix of inserts
+//              and erases. The tree depth is what differs, so the large
+//              sizes are the interesting ones:
+//                stl_bench --filter=btree_map/ --sizes=1024,1048576,16777216
+
+#include "harness.h"
+#include "maps.h"
+
+#include "btree_map.h"
+#include "map.h"
+
+#include <map>
+
+namespace {
+
+template <class M>
+unsigned long map_insert_random(unsigned n) {
+  M m;
+  map_build(m, n);
+  bench_sink(m.size());
+  return n;
+}
+
+// Every insert is followed by the erase of a key inserted earlier, so the
+// map grows to n / 2 with erases spread over its whole key range.
+template <class M>
+unsigned long map_mixed(unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  M m;
+  for (unsigned i = 0; i < n; i++) {
+    map_insert(m, keys[i], i);
+    if (i & 1) m.erase(keys[i / 2]);
+  }
+  bench_sink(m.size());
+  return n + n / 2;
+}
+
+typedef btree_map<unsigned, unsigned> stl_btree_map;
+typedef map<unsigned, unsigned> stl_map;
+typedef std::map<unsigned, unsigned> std_map;
+
+const unsigned kHuge = 1u << 24;
+
+}  // namespace
+
+STL_BENCH("btree_map", "find_hit", "btree_map", kHuge,
+          map_find_hit<stl_btree_map>);
+STL_BENCH("btree_map", "find_hit", "map", kHuge, map_find_hit<stl_map>);
+STL_BENCH("btree_map", "find_hit", "std", kHuge, map_find_hit<std_map>);
+STL_BENCH("btree_map", "find_miss", "btree_map", kHuge,
+          map_find_miss<stl_btree_map>);
+STL_BENCH("btree_map", "find_miss", "map", kHuge, map_find_miss<stl_map>);
+STL_BENCH("btree_map", "find_miss", "std", kHuge, map_find_miss<std_map>);
+STL_BENCH("btree_map", "scan", "btree_map", kHuge,
+          map_iterate<stl_btree_map>);
+STL_BENCH("btree_map", "scan", "map", kHuge, map_iterate<stl_map>);
+STL_BENCH("btree_map", "scan", "std", kHuge, map_iterate<std_map>);
+STL_BENCH("btree_map", "insert_random", "btree_map", kHuge,
+          map_insert_random<stl_btree_map>);
+STL_BENCH("btree_map", "insert_random", "map", kHuge,
+          map_insert_random<stl_map>);
+STL_BENCH("btree_map", "insert_random", "std", kHuge,
+          map_insert_random<std_map>);
+STL_BENCH("btree_map", "insert_erase", "btree_map", kHuge,
+          map_mixed<stl_btree_map>);
+STL_BENCH("btree_map", "insert_erase", "map", kHuge, map_mixed<stl_map>);
+STL_BENCH("btree_map", "insert_erase", "std", kHuge, map_mixed<std_map>);
@@ -0,0 +1,344 @@
+// File: bench/containers_bench.cc
+//
+// Description: The basic operations of vector, list, map, queue, stack and
+//              the heap algorithms, each next to its std:: counterpart.
+
+#include "harness.h"
+#include "maps.h"
+
+#include "algo.h"
+#include "list.h"
+#include "map.h"
+#include "queue.h"
+#include "stack.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <list>
+#include <queue>
+#include <stack>
+#include <vector>
+
+namespace {
+
+template <class V>
+unsigned long vector_push_back(unsigned n) {
+  V v;
+  for (unsigned i = 0; i < n; i++) v.push_back(i);
+  bench_sink(v.size());
+  return n;
+}
+
+template <class V>
+unsigned long vector_pop_back(unsigned n) {
+  static V v;
+  if (v.size() != n) v.resize(n);
+  V w(v);
+  for (unsigned i = 0; i < n; i++) w.pop_back();
+  bench_sink(w.size());
+  return n;
+}
+
+template <class V>
+unsigned long vector_iterate(unsigned n) {
+  static V v;
+  if (v.size() != n) {
+    v.clear();
+    for (unsigned i = 0; i < n; i++) v.push_back(bench_keys(n)[i]);
+  }
+  unsigned long sum = 0;
+  for (typename V::iterator it = v.begin(); it != v.end(); ++it) sum += *it;
+  bench_sink(sum);
+  return n;
+}
+
+template <class V>
+unsigned long vector_copy(unsigned n) {
+  static V v;
+  if (v.size() != n) v.resize(n);
+  V w(v);
+  bench_sink(w.size());
+  return n;
+}
+
+template <class V>
+unsigned long vector_insert_erase(unsigned n) {
+  V v;
+  for (unsigned i = 0; i < n; i++) v.insert(v.begin() + i / 2, i);
+  while (v.size()) v.erase(v.begin() + v.size() / 2);
+  bench_sink(v.size());
+  return 2ul * n;
+}
+
+template <class L>
+unsigned long list_push_back(unsigned n) {
+  L l;
+  for (unsigned i = 0; i < n; i++) l.push_back(i);
+  bench_sink(l.size());
+  return n;
+}
+
+template <class L>
+unsigned long list_push_pop_front(unsigned n) {
+  L l;
+  for (unsigned i = 0; i < n; i++) l.push_front(i);
+  for (unsigned i = 0; i < n; i++) l.pop_front();
+  bench_sink(l.size());
+  return 2ul * n;
+}
+
+template <class L>
+unsigned long list_iterate(unsigned n) {
+  static L l;
+  if (l.size() != n) {
+    l.clear();
+    for (unsigned i = 0; i < n; i++) l.push_back(bench_keys(n)[i]);
+  }
+  unsigned long sum = 0;
+  for (typename L::iterator it = l.begin(); it != l.end(); ++it) sum += *it;
+  bench_sink(sum);
+  return n;
+}
+
+template <class L>
+unsigned long list_copy(unsigned n) {
+  static L l;
+  if (l.size() != n) {
+    l.clear();
+    for (unsigned i = 0; i < n; i++) l.push_back(i);
+  }
+  L w(l);
+  bench_sink(w.size());
+  return n;
+}
+
+// Inserts before and erases at an iterator, the operations a linked list
+// exists for.
+template <class L>
+unsigned long list_insert_erase(unsigned n) {
+  L l;
+  l.push_back(0);
+  typename L::iterator it = l.begin();
+  for (unsigned i = 0; i < n; i++) l.insert(it, i);
+  for (unsigned i = 0; i < n; i++) l.erase(l.begin());
+  bench_sink(l.size());
+  return 2ul * n;
+}
+
+template <class M>
+unsigned long map_insert_random(unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  M m;
+  for (unsigned i = 0; i < n; i++) map_insert(m, keys[i], i);
+  bench_sink(m.size());
+  return n;
+}
+
+template <class M>
+unsigned long map_insert_sequential(unsigned n) {
+  M m;
+  for (unsigned i = 0; i < n; i++) map_insert(m, i, i);
+  bench_sink(m.size());
+  return n;
+}
+
+template <class M>
+unsigned long map_insert_erase(unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  M m;
+  for (unsigned i = 0; i < n; i++) map_insert(m, keys[i], i);
+  for (unsigned i = 0; i < n; i++) m.erase(keys[i]);
+  bench_sink(m.size());
+  return 2ul * n;
+}
+
+template <class Q>
+unsigned long queue_push_pop(unsigned n) {
+  Q q;
+  for (unsigned i = 0; i < n; i++) q.push(i);
+  unsigned long sum = 0;
+  for (unsigned i = 0; i < n; i++) {
+    sum += q.front();
+    q.pop();
+  }
+  bench_sink(sum);
+  return 2ul * n;
+}
+
+// A queue that stays short: the steady state of a producer/consumer pair.
+template <class Q>
+unsigned long queue_steady(unsigned n) {
+  Q q;
+  unsigned long sum = 0;
+  for (unsigned i = 0; i < n; i++) {
+    q.push(i);
+    q.push(i);
+    sum += q.front();
+    q.pop();
+  }
+  bench_sink(sum + q.size());
+  return 3ul * n;
+}
+
+template <class S>
+unsigned long stack_push_pop(unsigned n) {
+  S s;
+  for (unsigned i = 0; i < n; i++) s.push(i);
+  unsigned long sum = 0;
+  for (unsigned i = 0; i < n; i++) {
+    sum += s.top();
+    s.pop();
+  }
+  bench_sink(sum);
+  return 2ul * n;
+}
+
+struct std_heap_ops {
+  template <class It>
+  static void make(It first, It last) {
+    std::make_heap(first, last);
+  }
+  template <class It>
+  static void push(It first, It last) {
+    std::push_heap(first, last);
+  }
+  template <class It>
+  static void pop(It first, It last) {
+    std::pop_heap(first, last);
+  }
+};
+
+struct stl_heap_ops {
+  template <class It>
+  static void make(It first, It last) {
+    ::make_heap(first, last);
+  }
+  template <class It>
+  static void push(It first, It last) {
+    ::push_heap(first, last);
+  }
+  template <class It>
+  static void pop(It first, It last) {
+    ::pop_heap(first, last);
+  }
+};
+
+// Fills v with the n keys, reusing its storage.
+template <class V>
+void heap_fill(V& v, unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  v.resize(n);
+  for (unsigned i = 0; i < n; i++) v[i] = keys[i];
+}
+
+template <class V, class Ops>
+unsigned long heap_make(unsigned n) {
+  static V v;
+  heap_fill(v, n);
+  Ops::make(v.begin(), v.end());
+  bench_sink(v[0]);
+  return n;
+}
+
+template <class V, class Ops>
+unsigned long heap_push(unsigned n) {
+  static V v;
+  heap_fill(v, n);
+  for (unsigned i = 1; i < n; i++) Ops::push(v.begin(), v.begin() + (i + 1));
+  bench_sink(v[0]);
+  return n;
+}
+
+template <class V, class Ops>
+unsigned long heap_pop(unsigned n) {
+  static V v;
+  heap_fill(v, n);
+  Ops::make(v.begin(), v.end());
+  for (unsigned i = n; i > 1; i--) Ops::pop(v.begin(), v.begin() + i);
+  bench_sink(v[0]);
+  return n;
+}
+
+typedef vector<unsigned> stl_vector;
+typedef std::vector<unsigned> std_vector;
+typedef list<unsigned> stl_list;
+typedef std::list<unsigned> std_list;
+typedef map<unsigned, unsigned> stl_map;
+typedef std::map<unsigned, unsigned> std_map;
+// The list-backed layout stack had before it moved to vector.
+typedef _stack_adapter<unsigned, list<unsigned> > list_stack;
+typedef small_stack<unsigned, 16> stl_small_stack;
+
+const unsigned kLarge = 1u << 20;
+// Cases that are O(n^2) over a vector, such as inserting in the middle.
+const unsigned kQuadratic = 1u << 16;
+
+}  // namespace
+
+STL_BENCH("vector", "push_back", "stl", kLarge, vector_push_back<stl_vector>);
+STL_BENCH("vector", "push_back", "std", kLarge, vector_push_back<std_vector>);
+STL_BENCH("vector", "pop_back", "stl", kLarge, vector_pop_back<stl_vector>);
+STL_BENCH("vector", "pop_back", "std", kLarge, vector_pop_back<std_vector>);
+STL_BENCH("vector", "iterate", "stl", kLarge, vector_iterate<stl_vector>);
+STL_BENCH("vector", "iterate", "std", kLarge, vector_iterate<std_vector>);
+STL_BENCH("vector", "copy", "stl", kLarge, vector_copy<stl_vector>);
+STL_BENCH("vector", "copy", "std", kLarge, vector_copy<std_vector>);
+STL_BENCH("vector", "insert_erase", "stl", kQuadratic,
+          vector_insert_erase<stl_vector>);
+STL_BENCH("vector", "insert_erase", "std", kQuadratic,
+          vector_insert_erase<std_vector>);
+
+STL_BENCH("list", "push_back", "stl", kLarge, list_push_back<stl_list>);
+STL_BENCH("list", "push_back", "std", kLarge, list_push_back<std_list>);
+STL_BENCH("list", "push_pop_front", "stl", kLarge,
+          list_push_pop_front<stl_list>);
+STL_BENCH("list", "push_pop_front", "std", kLarge,
+          list_push_pop_front<std_list>);
+STL_BENCH("list", "iterate", "stl", kLarge, list_iterate<stl_list>);
+STL_BENCH("list", "iterate", "std", kLarge, list_iterate<std_list>);
+STL_BENCH("list", "copy", "stl", kLarge, list_copy<stl_list>);
+STL_BENCH("list", "copy", "std", kLarge, list_copy<std_list>);
+STL_BENCH("list", "insert_erase", "stl", kLarge, list_insert_erase<stl_list>);
+STL_BENCH("list", "insert_erase", "std", kLarge, list_insert_erase<std_list>);
+
+STL_BENCH("map", "insert_random", "stl", kLarge, map_insert_random<stl_map>);
+STL_BENCH("map", "insert_random", "std", kLarge, map_insert_random<std_map>);
+STL_BENCH("map", "insert_sequential", "stl", kLarge,
+          map_insert_sequential<stl_map>);
+STL_BENCH("map", "insert_sequential", "std", kLarge,
+          map_insert_sequential<std_map>);
+STL_BENCH("map", "find_hit", "stl", kLarge, map_find_hit<stl_map>);
+STL_BENCH("map", "find_hit", "std", kLarge, map_find_hit<std_map>);
+STL_BENCH("map", "find_miss", "stl", kLarge, map_find_miss<stl_map>);
+STL_BENCH("map", "find_miss", "std", kLarge, map_find_miss<std_map>);
+STL_BENCH("map", "insert_erase", "stl", kLarge, map_insert_erase<stl_map>);
+STL_BENCH("map", "insert_erase", "std", kLarge, map_insert_erase<std_map>);
+STL_BENCH("map", "iterate", "stl", kLarge, map_iterate<stl_map>);
+STL_BENCH("map", "iterate", "std", kLarge, map_iterate<std_map>);
+
+STL_BENCH("queue", "push_pop", "stl", kLarge, queue_push_pop<queue<unsigned> >);
+STL_BENCH("queue", "push_pop", "std", kLarge,
+          queue_push_pop<std::queue<unsigned> >);
+STL_BENCH("queue", "steady", "stl", kLarge, queue_steady<queue<unsigned> >);
+STL_BENCH("queue", "steady", "std", kLarge,
+          queue_steady<std::queue<unsigned> >);
+
+STL_BENCH("stack", "push_pop", "stl", kLarge, stack_push_pop<stack<unsigned> >);
+STL_BENCH("stack", "push_pop", "std", kLarge,
+          stack_push_pop<std::stack<unsigned> >);
+STL_BENCH("stack", "push_pop", "list", kLarge, stack_push_pop<list_stack>);
+STL_BENCH("stack", "push_pop", "small_stack", kLarge,
+          stack_push_pop<stl_small_stack>);
+
+STL_BENCH("heap", "make_heap", "stl", kLarge,
+          heap_make<stl_vector, stl_heap_ops>);
+STL_BENCH("heap", "make_heap", "std", kLarge,
+          heap_make<std_vector, std_heap_ops>);
+STL_BENCH("heap", "push_heap", "stl", kLarge,
+          heap_push<stl_vector, stl_heap_ops>);
+STL_BENCH("heap", "push_heap", "std", kLarge,
+          heap_push<std_vector, std_heap_ops>);
+STL_BENCH("heap", "pop_heap", "stl", kLarge,
+          heap_pop<stl_vector, stl_heap_ops>);
+STL_BENCH("heap", "pop_heap", "std", kLarge,
+          heap_pop<std_vector, std_heap_ops>);
@@ -0,0 +1,50 @@
+// File: bench/flat_map_bench.cc
+//
+// Description: Lookups in flat_map against map and std::map, and the cost of
+//              building each from unsorted keys. 1K keys fit in L1, 100K
+//              in L2 or L3 and 10M only in memory, so these sizes show
+//              where the contiguous array pulls ahead of the trees:
+//                stl_bench --filter=flat_map/ --sizes=1000,100000,10000000
+
+#include "harness.h"
+#include "maps.h"
+
+#include "flat_map.h"
+#include "map.h"
+
+#include <map>
+
+namespace {
+
+template <class M>
+unsigned long map_build_random(unsigned n) {
+  M m;
+  map_build(m, n);
+  bench_sink(m.size());
+  return n;
+}
+
+typedef flat_map<unsigned, unsigned> stl_flat_map;
+typedef map<unsigned, unsigned> stl_map;
+typedef std::map<unsigned, unsigned> std_map;
+
+const unsigned kHuge = 1u << 24;
+
+}  // namespace
+
+STL_BENCH("flat_map", "find_hit", "flat_map", kHuge,
+          map_find_hit<stl_flat_map>);
+STL_BENCH("flat_map", "find_hit", "map", kHuge, map_find_hit<stl_map>);
+STL_BENCH("flat_map", "find_hit", "std", kHuge, map_find_hit<std_map>);
+STL_BENCH("flat_map", "find_miss", "flat_map", kHuge,
+          map_find_miss<stl_flat_map>);
+STL_BENCH("flat_map", "find_miss", "map", kHuge, map_find_miss<stl_map>);
+STL_BENCH("flat_map", "find_miss", "std", kHuge, map_find_miss<std_map>);
+STL_BENCH("flat_map", "iterate", "flat_map", kHuge,
+          map_iterate<stl_flat_map>);
+STL_BENCH("flat_map", "iterate", "map", kHuge, map_iterate<stl_map>);
+STL_BENCH("flat_map", "iterate", "std", kHuge, map_iterate<std_map>);
+STL_BENCH("flat_map", "build", "flat_map", kHuge,
+          map_build_random<stl_flat_map>);
+STL_BENCH("flat_map", "build", "map", kHuge, map_build_random<stl_map>);
+STL_BENCH("flat_map", "build", "std", kHuge, map_build_random<std_map>);
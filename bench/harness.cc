@@ -0,0 +1,209 @@
+// File: bench/harness.cc
+//
+// Description: Runs the cases registered with STL_BENCH. Global operator new
+//              and delete are replaced to count allocations and track the
+//              bytes live on the heap.
+//
+//   stl_bench [--filter=substr] [--sizes=16,1024,...] [--min-time=sec]
+//             [--threads=n] [--format=json|csv|table]
+
+#include "harness.h"
+
+#include <atomic>
+#include <chrono>
+#include <malloc.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<unsigned long> g_allocs(0), g_bytes(0), g_live(0), g_peak(0);
+
+void* counted_alloc(size_t n) {
+  void* p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  size_t size = malloc_usable_size(p);
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(n, std::memory_order_relaxed);
+  unsigned long live =
+      g_live.fetch_add(size, std::memory_order_relaxed) + size;
+  unsigned long peak = g_peak.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !g_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+  return p;
+}
+
+void counted_free(void* p) {
+  if (!p) return;
+  g_live.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+  free(p);
+}
+
+struct bench_case {
+  const char* group;
+  const char* op;
+  const char* impl;
+  unsigned max_size;
+  bench_fn fn;
+};
+
+std::vector<bench_case>& registry() {
+  static std::vector<bench_case> cases;
+  return cases;
+}
+
+unsigned g_threads = 0;
+volatile unsigned long g_sink;
+
+double now() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct result {
+  unsigned long passes, ops, allocs, bytes, peak;
+  double seconds;
+};
+
+// passes is 0 if the case skipped itself.
+result measure(const bench_case& c, unsigned n, double min_time) {
+  result r = {0, 0, 0, 0, 0, 0.0};
+  if (!c.fn(n)) return r;
+  unsigned long allocs = g_allocs.load(), bytes = g_bytes.load();
+  double start = now();
+  do {
+    unsigned long live = g_live.load();
+    g_peak.store(live);
+    r.ops += c.fn(n);
+    r.passes++;
+    unsigned long peak = g_peak.load() - live;
+    if (peak > r.peak) r.peak = peak;
+    r.seconds = now() - start;
+  } while (r.seconds < min_time && r.passes < 1000000);
+  r.allocs = g_allocs.load() - allocs;
+  r.bytes = g_bytes.load() - bytes;
+  return r;
+}
+
+void print(const char* format, const bench_case& c, unsigned n,
+           const result& r) {
+  double ops = r.ops ? (double)r.ops : 1.0;
+  double ns = r.seconds * 1e9 / ops;
+  if (!strcmp(format, "csv"))
+    printf("%s,%s,%s,%u,%lu,%.3f,%.4f,%.2f,%lu\n", c.group, c.op, c.impl, n,
+           r.passes, ns, r.allocs / ops, r.bytes / ops, r.peak);
+  else if (!strcmp(format, "table"))
+    printf("%-14s %-18s %-14s %9u %12.2f %10.4f %10.2f %12lu\n", c.group,
+           c.op, c.impl, n, ns, r.allocs / ops, r.bytes / ops, r.peak);
+  else
+    printf(
+        "{\"group\":\"%s\",\"op\":\"%s\",\"impl\":\"%s\",\"size\":%u,"
+        "\"passes\":%lu,\"ns_per_op\":%.3f,\"allocs_per_op\":%.4f,"
+        "\"bytes_per_op\":%.2f,\"peak_bytes\":%lu}\n",
+        c.group, c.op, c.impl, n, r.passes, ns, r.allocs / ops, r.bytes / ops,
+        r.peak);
+  fflush(stdout);
+}
+
+}  // namespace
+
+void* operator new(size_t n) { return counted_alloc(n); }
+void* operator new[](size_t n) { return counted_alloc(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+  try {
+    return counted_alloc(n);
+  } catch (...) {
+    return 0;
+  }
+}
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, size_t) noexcept { counted_free(p); }
+
+bench_registrar::bench_registrar(const char* group, const char* op,
+                                 const char* impl, unsigned max_size,
+                                 bench_fn fn) {
+  bench_case c = {group, op, impl, max_size, fn};
+  registry().push_back(c);
+}
+
+void bench_sink(unsigned long x) { g_sink = g_sink + x; }
+
+const unsigned* bench_keys(unsigned n) {
+  static std::vector<unsigned> keys;
+  if (keys.size() < n) {
+    unsigned x = 2463534242u;
+    keys.clear();
+    for (unsigned i = 0; i < n; i++) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      keys.push_back(x);
+    }
+  }
+  return keys.data();
+}
+
+unsigned bench_threads() { return g_threads; }
+
+int main(int argc, char** argv) {
+  const char* filter = "";
+  const char* format = "json";
+  double min_time = 0.05;
+  std::vector<unsigned> sizes;
+  g_threads = std::thread::hardware_concurrency();
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    if (!strncmp(a, "--filter=", 9)) {
+      filter = a + 9;
+    } else if (!strncmp(a, "--format=", 9)) {
+      format = a + 9;
+    } else if (!strncmp(a, "--min-time=", 11)) {
+      min_time = atof(a + 11);
+    } else if (!strncmp(a, "--threads=", 10)) {
+      g_threads = (unsigned)atoi(a + 10);
+    } else if (!strncmp(a, "--sizes=", 8)) {
+      for (const char* p = a + 8; *p;) {
+        sizes.push_back((unsigned)strtoul(p, (char**)&p, 10));
+        if (*p == ',') p++;
+      }
+    } else {
+      fprintf(stderr,
+              "usage: %s [--filter=substr] [--sizes=n,...] [--min-time=sec]"
+              " [--threads=n] [--format=json|csv|table]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (!g_threads) g_threads = 1;
+  if (sizes.empty()) {
+    sizes.push_back(16);
+    sizes.push_back(1024);
+    sizes.push_back(65536);
+  }
+  if (!strcmp(format, "csv"))
+    printf("group,op,impl,size,passes,ns_per_op,allocs_per_op,bytes_per_op,"
+           "peak_bytes\n");
+  else if (!strcmp(format, "table"))
+    printf("%-14s %-18s %-14s %9s %12s %10s %10s %12s\n", "group", "op",
+           "impl", "size", "ns/op", "allocs/op", "bytes/op", "peak_bytes");
+  for (size_t i = 0; i < registry().size(); i++) {
+    const bench_case& c = registry()[i];
+    char name[256];
+    snprintf(name, sizeof name, "%s/%s/%s", c.group, c.op, c.impl);
+    if (!strstr(name, filter)) continue;
+    for (size_t s = 0; s < sizes.size(); s++) {
+      if (!sizes[s] || sizes[s] > c.max_size) continue;
+      result r = measure(c, sizes[s], min_time);
+      if (r.passes) print(format, c, sizes[s], r);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,46 @@
+// File: bench/harness.h
+//
+// Description: Microbenchmark harness. A case does one operation n times per
+//              pass; the harness repeats passes until a minimum time has
+//              passed and reports ns/op, heap allocations and bytes per op,
+//              and the peak heap growth during a pass. Results go to stdout
+//              as one JSON object per line (or CSV, or a table).
+
+#ifndef _STL_BENCH_HARNESS_H_
+#define _STL_BENCH_HARNESS_H_
+
+// One pass over n elements; returns the number of operations done. The
+// first pass at each size is an untimed warm-up, so a case may build its
+// fixture (a container to look up in) there and keep it in a static. A case
+// that returns 0 from it is skipped, such as one that needs more threads
+// than bench_threads().
+typedef unsigned long (*bench_fn)(unsigned n);
+
+// Registers fn as group/op for impl (our containers are "stl", the baseline
+// "std", variants get their own name). It runs at the requested sizes up
+// to max_size.
+class bench_registrar {
+ public:
+  bench_registrar(const char* group, const char* op, const char* impl,
+                  unsigned max_size, bench_fn fn);
+};
+
+#define STL_BENCH_CAT2(a, b) a##b
+#define STL_BENCH_CAT(a, b) STL_BENCH_CAT2(a, b)
+// fn is variadic so that it may be a template-id with several arguments.
+// __COUNTER__ rather than __LINE__, so that a macro may register several.
+#define STL_BENCH(group, op, impl, max_size, ...)                          \
+  static bench_registrar STL_BENCH_CAT(bench_registrar_, __COUNTER__)(     \
+      group, op, impl, max_size, __VA_ARGS__)
+
+// Keeps x alive, so that the work producing it isn't optimized away.
+void bench_sink(unsigned long x);
+
+// The same n pseudo-random keys on every call.
+const unsigned* bench_keys(unsigned n);
+
+// Threads the concurrent cases may use, from --threads (default: the number
+// of hardware threads).
+unsigned bench_threads();
+
+#endif  // _STL_BENCH_HARNESS_H_
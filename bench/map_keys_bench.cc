@@ -0,0 +1,206 @@
+// File: bench/map_keys_bench.cc
+//
+// Description: map with keys that are expensive to compare: long strings
+//              sharing a prefix, as in configuration paths, and pairs with
+//              such a string first. "stl" orders them with one three-way
+//              compare() per node; "stl_less" uses the same keys
+//              with only operator<, which costs up to two calls per node,
+//              as map did before compare(). The erase cases also cover the
+//              single descent of erase().
+
+#include "harness.h"
+
+#include "map.h"
+
+#include <map>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char kPrefix[] = "/etc/application/settings/network/interfaces/";
+
+// Ordered by three-way compare(), which is all that map uses.
+struct path_key {
+  std::string s;
+};
+int compare(const path_key& lhs, const path_key& rhs) {
+  return lhs.s.compare(rhs.s);
+}
+
+// The same, with operator< alone.
+struct less_only_key {
+  std::string s;
+};
+int operator<(const less_only_key& lhs, const less_only_key& rhs) {
+  return lhs.s < rhs.s;
+}
+
+std::string make_path(unsigned x) {
+  char buf[sizeof(kPrefix) + 16];
+  snprintf(buf, sizeof buf, "%s%08x", kPrefix, x);
+  return buf;
+}
+
+// The key of type K for x; K is picked by the null pointer.
+template <class K>
+K make_key(unsigned x, const K*) {
+  K k;
+  k.s = make_path(x);
+  return k;
+}
+
+template <class K1, class K2>
+pair<K1, K2> make_key(unsigned x, const pair<K1, K2>*) {
+  return make_pair(make_key(x, (const K1*)0), (K2)x);
+}
+
+std::string make_key(unsigned x, const std::string*) { return make_path(x); }
+
+std::pair<std::string, unsigned> make_key(
+    unsigned x, const std::pair<std::string, unsigned>*) {
+  return std::make_pair(make_path(x), x);
+}
+
+template <class K, class V>
+void key_insert(map<K, V>& m, const K& k, V v) {
+  m.insert(k, v);
+}
+template <class K, class V>
+void key_insert(std::map<K, V>& m, const K& k, V v) {
+  m.insert(std::make_pair(k, v));
+}
+
+// The n bench keys as K, plus offset, built once per size.
+template <class K>
+const K* keys_as(unsigned n, unsigned offset) {
+  static std::vector<K> keys[2];
+  std::vector<K>& v = keys[offset != 0];
+  if (v.size() != n) {
+    v.clear();
+    const unsigned* raw = bench_keys(n);
+    for (unsigned i = 0; i < n; i++)
+      v.push_back(make_key(raw[i] + offset, (const K*)0));
+  }
+  return v.data();
+}
+
+template <class K>
+const K* keys_as(unsigned n) {
+  return keys_as<K>(n, 0);
+}
+
+// Keys that sort among the others but aren't in the map.
+template <class K>
+const K* missing_keys(unsigned n) {
+  return keys_as<K>(n, 1);
+}
+
+template <class M, class K>
+M& key_fixture(unsigned n, const K*) {
+  static M* m = 0;
+  static unsigned built = 0;
+  if (!m || built != n) {
+    delete m;
+    m = new M;
+    const K* keys = keys_as<K>(n);
+    for (unsigned i = 0; i < n; i++) key_insert(*m, keys[i], i);
+    built = n;
+  }
+  return *m;
+}
+
+template <class M, class K>
+unsigned long key_find_hit(unsigned n) {
+  M& m = key_fixture<M>(n, (const K*)0);
+  const K* keys = keys_as<K>(n);
+  unsigned long found = 0;
+  for (unsigned i = 0; i < n; i++) found += m.find(keys[n - 1 - i]) != m.end();
+  bench_sink(found);
+  return n;
+}
+
+template <class M, class K>
+unsigned long key_find_miss(unsigned n) {
+  M& m = key_fixture<M>(n, (const K*)0);
+  const K* keys = missing_keys<K>(n);
+  unsigned long found = 0;
+  for (unsigned i = 0; i < n; i++) found += m.find(keys[i]) != m.end();
+  bench_sink(found);
+  return n;
+}
+
+// Inserts the keys and erases them all again.
+template <class M, class K>
+unsigned long key_insert_erase(unsigned n) {
+  const K* keys = keys_as<K>(n);
+  M m;
+  for (unsigned i = 0; i < n; i++) key_insert(m, keys[i], i);
+  for (unsigned i = 0; i < n; i++) m.erase(keys[i]);
+  bench_sink(m.size());
+  return 2ul * n;
+}
+
+// Erases keys that aren't there, which leaves the fixture as it was.
+template <class M, class K>
+unsigned long key_erase_miss(unsigned n) {
+  M& m = key_fixture<M>(n, (const K*)0);
+  const K* keys = missing_keys<K>(n);
+  for (unsigned i = 0; i < n; i++) m.erase(keys[i]);
+  bench_sink(m.size());
+  return n;
+}
+
+typedef pair<path_key, unsigned> path_pair;
+typedef pair<less_only_key, unsigned> less_only_pair;
+typedef std::pair<std::string, unsigned> std_pair;
+
+typedef map<path_key, unsigned> stl_string_map;
+typedef map<less_only_key, unsigned> less_only_string_map;
+typedef std::map<std::string, unsigned> std_string_map;
+typedef map<path_pair, unsigned> stl_pair_map;
+typedef map<less_only_pair, unsigned> less_only_pair_map;
+typedef std::map<std_pair, unsigned> std_pair_map;
+
+const unsigned kLarge = 1u << 20;
+
+}  // namespace
+
+STL_BENCH("map_string", "find_hit", "stl", kLarge,
+          key_find_hit<stl_string_map, path_key>);
+STL_BENCH("map_string", "find_hit", "stl_less", kLarge,
+          key_find_hit<less_only_string_map, less_only_key>);
+STL_BENCH("map_string", "find_hit", "std", kLarge,
+          key_find_hit<std_string_map, std::string>);
+STL_BENCH("map_string", "find_miss", "stl", kLarge,
+          key_find_miss<stl_string_map, path_key>);
+STL_BENCH("map_string", "find_miss", "stl_less", kLarge,
+          key_find_miss<less_only_string_map, less_only_key>);
+STL_BENCH("map_string", "find_miss", "std", kLarge,
+          key_find_miss<std_string_map, std::string>);
+STL_BENCH("map_string", "insert_erase", "stl", kLarge,
+          key_insert_erase<stl_string_map, path_key>);
+STL_BENCH("map_string", "insert_erase", "stl_less", kLarge,
+          key_insert_erase<less_only_string_map, less_only_key>);
+STL_BENCH("map_string", "insert_erase", "std", kLarge,
+          key_insert_erase<std_string_map, std::string>);
+STL_BENCH("map_string", "erase_miss", "stl", kLarge,
+          key_erase_miss<stl_string_map, path_key>);
+STL_BENCH("map_string", "erase_miss", "stl_less", kLarge,
+          key_erase_miss<less_only_string_map, less_only_key>);
+STL_BENCH("map_string", "erase_miss", "std", kLarge,
+          key_erase_miss<std_string_map, std::string>);
+
+STL_BENCH("map_pair", "find_hit", "stl", kLarge,
+          key_find_hit<stl_pair_map, path_pair>);
+STL_BENCH("map_pair", "find_hit", "stl_less", kLarge,
+          key_find_hit<less_only_pair_map, less_only_pair>);
+STL_BENCH("map_pair", "find_hit", "std", kLarge,
+          key_find_hit<std_pair_map, std_pair>);
+STL_BENCH("map_pair", "find_miss", "stl", kLarge,
+          key_find_miss<stl_pair_map, path_pair>);
+STL_BENCH("map_pair", "find_miss", "stl_less", kLarge,
+          key_find_miss<less_only_pair_map, less_only_pair>);
+STL_BENCH("map_pair", "find_miss", "std", kLarge,
+          key_find_miss<std_pair_map, std_pair>);
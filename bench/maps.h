@@ -0,0 +1,101 @@
+// File: bench/maps.h
+//
+// Description: One interface over the map types for the benchmark cases:
+//              our maps and std::map differ in insert() and in how a miss
+//              is reported. map_fixture() builds a map of the n bench keys
+//              once and keeps it for the lookup cases.
+
+#ifndef _STL_BENCH_MAPS_H_
+#define _STL_BENCH_MAPS_H_
+
+#include "harness.h"
+
+#include "btree_map.h"
+#include "flat_map.h"
+#include "map.h"
+
+#include <map>
+
+inline void map_insert(map<unsigned, unsigned>& m, unsigned k, unsigned v) {
+  m.insert(k, v);
+}
+inline void map_insert(std::map<unsigned, unsigned>& m, unsigned k,
+                       unsigned v) {
+  m.insert(std::make_pair(k, v));
+}
+
+inline void map_insert(flat_map<unsigned, unsigned>& m, unsigned k,
+                       unsigned v) {
+  m.insert(k, v);
+}
+inline void map_insert(btree_map<unsigned, unsigned>& m, unsigned k,
+                       unsigned v) {
+  m.insert(k, v);
+}
+
+template <class M>
+int map_contains(M& m, unsigned k) {
+  return m.find(k) != m.end();
+}
+
+// Fills the empty m with the n bench keys.
+template <class M>
+void map_build(M& m, unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  for (unsigned i = 0; i < n; i++) map_insert(m, keys[i], i);
+}
+
+// flat_map is built the way it is meant to be, in bulk: one insert per key
+// would make the larger fixtures quadratic.
+inline void map_build(flat_map<unsigned, unsigned>& m, unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  vector<pair<unsigned, unsigned> > items;
+  items.reserve(n);
+  for (unsigned i = 0; i < n; i++) items.push_back(make_pair(keys[i], i));
+  m.assign(items);
+}
+
+template <class M>
+M& map_fixture(unsigned n) {
+  static M* m = 0;
+  static unsigned built = 0;
+  if (!m || built != n) {
+    delete m;
+    m = new M;
+    map_build(*m, n);
+    built = n;
+  }
+  return *m;
+}
+
+template <class M>
+unsigned long map_find_hit(unsigned n) {
+  M& m = map_fixture<M>(n);
+  const unsigned* keys = bench_keys(n);
+  unsigned long found = 0;
+  for (unsigned i = 0; i < n; i++) found += map_contains(m, keys[n - 1 - i]);
+  bench_sink(found);
+  return n;
+}
+
+template <class M>
+unsigned long map_find_miss(unsigned n) {
+  M& m = map_fixture<M>(n);
+  const unsigned* keys = bench_keys(n);
+  unsigned long found = 0;
+  for (unsigned i = 0; i < n; i++) found += map_contains(m, keys[i] + 1);
+  bench_sink(found);
+  return n;
+}
+
+template <class M>
+unsigned long map_iterate(unsigned n) {
+  M& m = map_fixture<M>(n);
+  unsigned long sum = 0;
+  for (typename M::iterator it = m.begin(); it != m.end(); ++it)
+    sum += it->second;
+  bench_sink(sum);
+  return n;
+}
+
+#endif  // _STL_BENCH_MAPS_H_
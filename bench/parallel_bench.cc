@@ -0,0 +1,116 @@
+// File: bench/parallel_bench.cc
+//
+// Description: Scaling of the parallel algorithms from 1 to 16 threads, next
+//              to the serial executor and, for sort, std::sort. Thread
+//              counts above --threads are skipped. Every pass of sort and
+//              make_heap also copies the input into place.
+
+#include "harness.h"
+
+#include "algo.h"
+#include "parallel.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace {
+
+// The pool of each thread count, started on first use and kept.
+executor& executor_for(unsigned threads) {
+  if (!threads) {
+    static serial_executor serial;
+    return serial;
+  }
+  static thread_pool* pools[17];
+  if (!pools[threads]) pools[threads] = new thread_pool(threads);
+  return *pools[threads];
+}
+
+vector<unsigned>& input(unsigned n) {
+  static vector<unsigned> v;
+  if (v.size() != n) {
+    const unsigned* keys = bench_keys(n);
+    v.clear();
+    for (unsigned i = 0; i < n; i++) v.push_back(keys[i]);
+  }
+  return v;
+}
+
+// A loop body with enough arithmetic per element to be worth spreading.
+struct scale {
+  void operator()(unsigned& x) const {
+    x = (unsigned)(sqrt((double)x) * 1000.0);
+  }
+};
+
+struct add {
+  unsigned long operator()(unsigned long a, unsigned long b) const {
+    return a + b;
+  }
+};
+
+template <unsigned kThreads>
+unsigned long par_sort(unsigned n) {
+  if (kThreads > bench_threads()) return 0;
+  static vector<unsigned> v;
+  v = input(n);
+  parallel_sort(executor_for(kThreads), v.begin(), v.end());
+  bench_sink(v[0]);
+  return n;
+}
+
+unsigned long std_sort(unsigned n) {
+  static vector<unsigned> v;
+  v = input(n);
+  std::sort(v.data(), v.data() + n);
+  bench_sink(v[0]);
+  return n;
+}
+
+template <unsigned kThreads>
+unsigned long par_make_heap(unsigned n) {
+  if (kThreads > bench_threads()) return 0;
+  static vector<unsigned> v;
+  v = input(n);
+  parallel_make_heap(executor_for(kThreads), v.begin(), v.end());
+  bench_sink(v[0]);
+  return n;
+}
+
+template <unsigned kThreads>
+unsigned long par_for_each(unsigned n) {
+  if (kThreads > bench_threads()) return 0;
+  static vector<unsigned> v;
+  if (v.size() != n) v = input(n);
+  parallel_for_each(executor_for(kThreads), v.begin(), v.end(), scale());
+  bench_sink(v[0]);
+  return n;
+}
+
+template <unsigned kThreads>
+unsigned long par_reduce(unsigned n) {
+  if (kThreads > bench_threads()) return 0;
+  vector<unsigned>& v = input(n);
+  bench_sink(parallel_reduce(executor_for(kThreads), v.begin(), v.end(),
+                             0ul, add()));
+  return n;
+}
+
+const unsigned kHuge = 1u << 24;
+
+}  // namespace
+
+#define PARALLEL_BENCH(op, fn)                                         \
+  STL_BENCH("parallel", op, "serial", kHuge, fn<0>);                   \
+  STL_BENCH("parallel", op, "threads_1", kHuge, fn<1>);                \
+  STL_BENCH("parallel", op, "threads_2", kHuge, fn<2>);                \
+  STL_BENCH("parallel", op, "threads_4", kHuge, fn<4>);                \
+  STL_BENCH("parallel", op, "threads_8", kHuge, fn<8>);                \
+  STL_BENCH("parallel", op, "threads_16", kHuge, fn<16>)
+
+PARALLEL_BENCH("sort", par_sort);
+STL_BENCH("parallel", "sort", "std", kHuge, std_sort);
+PARALLEL_BENCH("make_heap", par_make_heap);
+PARALLEL_BENCH("for_each", par_for_each);
+PARALLEL_BENCH("reduce", par_reduce);
@@ -0,0 +1,121 @@
+// File: bench/priority_queue_bench.cc
+//
+// Description: The d-ary and indexed priority queues at arities 2, 4 and 8,
+//              against push_heap/pop_heap on a vector ("heap_fns") and
+//              std::priority_queue, all as min-heaps of unsigned. The
+//              steady case is the timer pattern: pop the earliest and push
+//              a later one, with the queue size fixed.
+
+#include "harness.h"
+
+#include "algo.h"
+#include "queue.h"
+#include "vector.h"
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace {
+
+// The heap functions of algo.h behind the queue interface.
+class heap_fns_queue {
+ public:
+  int empty() const { return v_.empty(); }
+  const unsigned& top() const { return v_[0]; }
+  void push(unsigned x) {
+    v_.push_back(x);
+    push_heap(v_.begin(), v_.end());
+  }
+  void pop() {
+    pop_heap(v_.begin(), v_.end());
+    v_.pop_back();
+  }
+
+ private:
+  vector<unsigned> v_;
+};
+
+template <class Q>
+unsigned long pq_push_pop(unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  Q q;
+  for (unsigned i = 0; i < n; i++) q.push(keys[i]);
+  unsigned long sum = 0;
+  while (!q.empty()) {
+    sum += q.top();
+    q.pop();
+  }
+  bench_sink(sum);
+  return 2ul * n;
+}
+
+// The queue holds n keys throughout; each step replaces the top with a key
+// that orders later, as a timer queue rescheduling a periodic timer does.
+template <class Q>
+unsigned long pq_steady(unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  Q q;
+  for (unsigned i = 0; i < n; i++) q.push(keys[i] >> 1);
+  unsigned long sum = 0;
+  for (unsigned i = 0; i < n; i++) {
+    unsigned t = q.top();
+    q.pop();
+    q.push(t + (keys[i] >> 20));
+    sum += t;
+  }
+  bench_sink(sum);
+  return 3ul * n;
+}
+
+// Pushes n keys in the upper half of the range, then lowers each one into
+// the lower half.
+template <class Q>
+unsigned long pq_decrease_key(unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  static std::vector<unsigned> handles;
+  handles.resize(n);
+  Q q;
+  for (unsigned i = 0; i < n; i++) handles[i] = q.push(keys[i] | 0x80000000u);
+  for (unsigned i = 0; i < n; i++)
+    q.decrease_key(handles[i], keys[i] & 0x7fffffffu);
+  bench_sink(q.top());
+  return 2ul * n;
+}
+
+typedef d_ary_priority_queue<unsigned, 2> d2_queue;
+typedef d_ary_priority_queue<unsigned, 4> d4_queue;
+typedef d_ary_priority_queue<unsigned, 8> d8_queue;
+typedef indexed_priority_queue<unsigned, 2> indexed_d2_queue;
+typedef indexed_priority_queue<unsigned, 4> indexed_d4_queue;
+typedef indexed_priority_queue<unsigned, 8> indexed_d8_queue;
+typedef std::priority_queue<unsigned, std::vector<unsigned>,
+                            std::greater<unsigned> >
+    std_queue;
+
+const unsigned kLarge = 1u << 20;
+
+}  // namespace
+
+#define PQ_BENCH(op, fn)                                                   \
+  STL_BENCH("priority_queue", op, "d2", kLarge, fn<d2_queue>);             \
+  STL_BENCH("priority_queue", op, "d4", kLarge, fn<d4_queue>);             \
+  STL_BENCH("priority_queue", op, "d8", kLarge, fn<d8_queue>);             \
+  STL_BENCH("priority_queue", op, "indexed_d2", kLarge,                    \
+            fn<indexed_d2_queue>);                                         \
+  STL_BENCH("priority_queue", op, "indexed_d4", kLarge,                    \
+            fn<indexed_d4_queue>);                                         \
+  STL_BENCH("priority_queue", op, "indexed_d8", kLarge,                    \
+            fn<indexed_d8_queue>);                                         \
+  STL_BENCH("priority_queue", op, "heap_fns", kLarge, fn<heap_fns_queue>); \
+  STL_BENCH("priority_queue", op, "std", kLarge, fn<std_queue>)
+
+PQ_BENCH("push_pop", pq_push_pop);
+PQ_BENCH("steady", pq_steady);
+
+STL_BENCH("priority_queue", "decrease_key", "indexed_d2", kLarge,
+          pq_decrease_key<indexed_d2_queue>);
+STL_BENCH("priority_queue", "decrease_key", "indexed_d4", kLarge,
+          pq_decrease_key<indexed_d4_queue>);
+STL_BENCH("priority_queue", "decrease_key", "indexed_d8", kLarge,
+          pq_decrease_key<indexed_d8_queue>);
@@ -0,0 +1,129 @@
+// File: bench/sharded_map_bench.cc
+//
+// Description: Read scaling of sharded_map. n lookups of present keys are
+//              split over 1 to 16 threads, against a 64-shard map, the same
+//              map with a single shard (one shared lock), and a std::map
+//              behind a mutex. Thread counts above --threads are skipped;
+//              each pass includes starting the threads.
+
+#include "harness.h"
+
+#include "sharded_map.h"
+
+#include <map>
+#include <pthread.h>
+
+namespace {
+
+const unsigned kKeys = 1u << 16;
+
+template <unsigned kShards>
+sharded_map<unsigned, unsigned>& sharded_fixture() {
+  static sharded_map<unsigned, unsigned>* m = 0;
+  if (!m) {
+    m = new sharded_map<unsigned, unsigned>(kShards);
+    const unsigned* keys = bench_keys(kKeys);
+    for (unsigned i = 0; i < kKeys; i++) m->insert(keys[i], i);
+  }
+  return *m;
+}
+
+struct locked_map {
+  pthread_mutex_t mu;
+  std::map<unsigned, unsigned> items;
+
+  locked_map() {
+    pthread_mutex_init(&mu, 0);
+    const unsigned* keys = bench_keys(kKeys);
+    for (unsigned i = 0; i < kKeys; i++)
+      items.insert(std::make_pair(keys[i], i));
+  }
+
+  int find(unsigned key, unsigned& val) {
+    pthread_mutex_lock(&mu);
+    std::map<unsigned, unsigned>::iterator it = items.find(key);
+    int found = it != items.end();
+    if (found) val = it->second;
+    pthread_mutex_unlock(&mu);
+    return found;
+  }
+};
+
+locked_map& locked_fixture() {
+  static locked_map m;
+  return m;
+}
+
+// One thread's share of the lookups, starting at its own offset in the keys.
+template <class M>
+struct reader {
+  M* m;
+  unsigned first, count;
+  unsigned long sum;
+};
+
+template <class M>
+void* read_main(void* arg) {
+  reader<M>* r = (reader<M>*)arg;
+  const unsigned* keys = bench_keys(kKeys);
+  unsigned long sum = 0;
+  unsigned val = 0;
+  for (unsigned i = 0; i < r->count; i++)
+    if (r->m->find(keys[(r->first + i) & (kKeys - 1)], val)) sum += val;
+  r->sum = sum;
+  return 0;
+}
+
+template <class M, unsigned kThreads>
+unsigned long read(M& m, unsigned n) {
+  if (kThreads > bench_threads()) return 0;
+  reader<M> readers[kThreads];
+  pthread_t threads[kThreads];
+  for (unsigned t = 0; t < kThreads; t++) {
+    readers[t].m = &m;
+    readers[t].first = t * (kKeys / kThreads);
+    readers[t].count = n / kThreads;
+  }
+  for (unsigned t = 1; t < kThreads; t++)
+    pthread_create(&threads[t], 0, read_main<M>, &readers[t]);
+  read_main<M>(&readers[0]);
+  unsigned long sum = readers[0].sum;
+  for (unsigned t = 1; t < kThreads; t++) {
+    pthread_join(threads[t], 0);
+    sum += readers[t].sum;
+  }
+  bench_sink(sum);
+  return (unsigned long)readers[0].count * kThreads;
+}
+
+template <unsigned kThreads>
+unsigned long sharded_64(unsigned n) {
+  return read<sharded_map<unsigned, unsigned>, kThreads>(sharded_fixture<64>(),
+                                                         n);
+}
+
+template <unsigned kThreads>
+unsigned long sharded_1(unsigned n) {
+  return read<sharded_map<unsigned, unsigned>, kThreads>(sharded_fixture<1>(),
+                                                         n);
+}
+
+template <unsigned kThreads>
+unsigned long std_mutex(unsigned n) {
+  return read<locked_map, kThreads>(locked_fixture(), n);
+}
+
+const unsigned kLarge = 1u << 20;
+
+}  // namespace
+
+#define SHARDED_BENCH(impl, fn)                                       \
+  STL_BENCH("sharded_map", "find_threads_1", impl, kLarge, fn<1>);    \
+  STL_BENCH("sharded_map", "find_threads_2", impl, kLarge, fn<2>);    \
+  STL_BENCH("sharded_map", "find_threads_4", impl, kLarge, fn<4>);    \
+  STL_BENCH("sharded_map", "find_threads_8", impl, kLarge, fn<8>);    \
+  STL_BENCH("sharded_map", "find_threads_16", impl, kLarge, fn<16>)
+
+SHARDED_BENCH("stl", sharded_64);
+SHARDED_BENCH("stl_1_shard", sharded_1);
+SHARDED_BENCH("std_mutex", std_mutex);
@@ -0,0 +1,128 @@
+// File: bench/simd_bench.cc
+//
+// Description: The SSE2 overloads of find, count, equal, accumulate and
+//              min_element/max_element on raw int and float ranges, against
+//              the generic templates on the same pointers ("scalar") and
+//              against std::. find looks for a value that isn't there, so
+//              every case scans the whole range. Without SSE2 the "sse2"
+//              cases run the scalar overloads.
+
+#include "harness.h"
+
+#include "algo.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+enum { kFind, kCount, kEqual, kAccumulate, kMinElement, kMaxElement };
+
+// The overload set of algo.h, which picks the kernels for raw pointers.
+struct simd_ops {
+  template <class T>
+  static unsigned long run(int op, const T* first, const T* last,
+                           const T* other) {
+    switch (op) {
+      case kFind:
+        return ::find(first, last, (T)-1) - first;
+      case kCount:
+        return ::count(first, last, (T)-1);
+      case kEqual:
+        return ::equal(first, last, other);
+      case kAccumulate:
+        return (unsigned long)::accumulate(first, last, (T)0);
+      case kMinElement:
+        return ::min_element(first, last) - first;
+      default:
+        return ::max_element(first, last) - first;
+    }
+  }
+};
+
+// The generic templates, forced by the explicit template arguments.
+struct scalar_ops {
+  template <class T>
+  static unsigned long run(int op, const T* first, const T* last,
+                           const T* other) {
+    switch (op) {
+      case kFind:
+        return ::find<const T*, T>(first, last, (T)-1) - first;
+      case kCount:
+        return ::count<const T*, T>(first, last, (T)-1);
+      case kEqual:
+        return ::equal<const T*, const T*>(first, last, other);
+      case kAccumulate:
+        return (unsigned long)::accumulate<const T*, T>(first, last, (T)0);
+      case kMinElement:
+        return ::min_element<const T*>(first, last) - first;
+      default:
+        return ::max_element<const T*>(first, last) - first;
+    }
+  }
+};
+
+struct std_ops {
+  template <class T>
+  static unsigned long run(int op, const T* first, const T* last,
+                           const T* other) {
+    switch (op) {
+      case kFind:
+        return std::find(first, last, (T)-1) - first;
+      case kCount:
+        return std::count(first, last, (T)-1);
+      case kEqual:
+        return std::equal(first, last, other);
+      case kAccumulate:
+        return (unsigned long)std::accumulate(first, last, (T)0);
+      case kMinElement:
+        return std::min_element(first, last) - first;
+      default:
+        return std::max_element(first, last) - first;
+    }
+  }
+};
+
+// n non-negative values, and an equal copy for equal().
+template <class T>
+const T* simd_input(unsigned n, int copy) {
+  static vector<T> v[2];
+  if (v[0].size() != n) {
+    const unsigned* keys = bench_keys(n);
+    v[0].clear();
+    for (unsigned i = 0; i < n; i++) v[0].push_back((T)(keys[i] >> 8));
+    v[1] = v[0];
+  }
+  return v[copy].data();
+}
+
+template <class T, class Ops, int op>
+unsigned long simd_case(unsigned n) {
+  const T* v = simd_input<T>(n, 0);
+  bench_sink(Ops::run(op, v, v + n, simd_input<T>(n, 1)));
+  return n;
+}
+
+const unsigned kLarge = 1u << 22;
+
+}  // namespace
+
+#define SIMD_BENCH_IMPLS(group, name, T, op)                            \
+  STL_BENCH(group, name, "sse2", kLarge, simd_case<T, simd_ops, op>);   \
+  STL_BENCH(group, name, "scalar", kLarge, simd_case<T, scalar_ops, op>); \
+  STL_BENCH(group, name, "std", kLarge, simd_case<T, std_ops, op>)
+
+SIMD_BENCH_IMPLS("simd_int", "find", int, kFind);
+SIMD_BENCH_IMPLS("simd_int", "count", int, kCount);
+SIMD_BENCH_IMPLS("simd_int", "equal", int, kEqual);
+SIMD_BENCH_IMPLS("simd_int", "accumulate", int, kAccumulate);
+SIMD_BENCH_IMPLS("simd_int", "min_element", int, kMinElement);
+SIMD_BENCH_IMPLS("simd_int", "max_element", int, kMaxElement);
+
+// accumulate over floats has no kernel, see algo.h.
+SIMD_BENCH_IMPLS("simd_float", "find", float, kFind);
+SIMD_BENCH_IMPLS("simd_float", "count", float, kCount);
+SIMD_BENCH_IMPLS("simd_float", "equal", float, kEqual);
+SIMD_BENCH_IMPLS("simd_float", "min_element", float, kMinElement);
+SIMD_BENCH_IMPLS("simd_float", "max_element", float, kMaxElement);
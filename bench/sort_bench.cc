@@ -0,0 +1,124 @@
+// File: bench/sort_bench.cc
+//
+// Description: sort, heap_sort, stable_sort and partial_sort (of the first
+//              sixteenth) against their std:: counterparts on random,
+//              sorted, reverse-sorted and many-duplicates input. "heap" is
+//              make_heap followed by sort_heap, the way ranges were sorted
+//              before algo.h had a sort. Every pass also copies the input
+//              into place, which is the same for all of them.
+
+#include "harness.h"
+
+#include "algo.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+enum { kRandom, kSorted, kReverse, kDuplicates };
+enum { kSort, kHeapSort, kStableSort, kPartialSort, kHeap };
+
+struct stl_sort_ops {
+  template <class It>
+  static void run(int algo, It first, It last) {
+    switch (algo) {
+      case kSort:
+        ::sort(first, last);
+        break;
+      case kHeapSort:
+        ::heap_sort(first, last);
+        break;
+      case kStableSort:
+        ::stable_sort(first, last);
+        break;
+      case kPartialSort:
+        ::partial_sort(first, first + (last - first) / 16, last);
+        break;
+      case kHeap:
+        ::make_heap(first, last);
+        ::sort_heap(first, last);
+        break;
+    }
+  }
+};
+
+struct std_sort_ops {
+  template <class It>
+  static void run(int algo, It first, It last) {
+    switch (algo) {
+      case kSort:
+        std::sort(first, last);
+        break;
+      case kHeapSort:
+      case kHeap:
+        std::make_heap(first, last);
+        std::sort_heap(first, last);
+        break;
+      case kStableSort:
+        std::stable_sort(first, last);
+        break;
+      case kPartialSort:
+        std::partial_sort(first, first + (last - first) / 16, last);
+        break;
+    }
+  }
+};
+
+template <class V>
+void fill_input(V& v, int kind, unsigned n) {
+  const unsigned* keys = bench_keys(n);
+  v.resize(n);
+  for (unsigned i = 0; i < n; i++) {
+    switch (kind) {
+      case kRandom:
+        v[i] = keys[i];
+        break;
+      case kSorted:
+        v[i] = i;
+        break;
+      case kReverse:
+        v[i] = n - i;
+        break;
+      case kDuplicates:
+        v[i] = keys[i] % 16;
+        break;
+    }
+  }
+}
+
+template <class V, class Ops, int kind, int algo>
+unsigned long sort_case(unsigned n) {
+  static V input, v;
+  if (input.size() != n) fill_input(input, kind, n);
+  v = input;
+  Ops::run(algo, v.begin(), v.end());
+  bench_sink(v[0]);
+  return n;
+}
+
+typedef vector<unsigned> stl_vector;
+typedef std::vector<unsigned> std_vector;
+
+const unsigned kLarge = 1u << 20;
+
+}  // namespace
+
+#define SORT_BENCH_ALGO(group, kind, op, algo)                          \
+  STL_BENCH(group, op, "stl", kLarge,                                   \
+            sort_case<stl_vector, stl_sort_ops, kind, algo>);           \
+  STL_BENCH(group, op, "std", kLarge,                                   \
+            sort_case<std_vector, std_sort_ops, kind, algo>)
+
+#define SORT_BENCH(group, kind)                                         \
+  SORT_BENCH_ALGO(group, kind, "sort", kSort);                          \
+  SORT_BENCH_ALGO(group, kind, "heap_sort", kHeapSort);                 \
+  SORT_BENCH_ALGO(group, kind, "stable_sort", kStableSort);             \
+  SORT_BENCH_ALGO(group, kind, "partial_sort", kPartialSort);           \
+  SORT_BENCH_ALGO(group, kind, "heap", kHeap)
+
+SORT_BENCH("sort_random", kRandom);
+SORT_BENCH("sort_sorted", kSorted);
+SORT_BENCH("sort_reverse", kReverse);
+SORT_BENCH("sort_dups", kDuplicates);
@@ -0,0 +1,143 @@
+// File: bench/spsc_ring_bench.cc
+//
+// Description: Throughput of spsc_ring. push_pop is one thread pushing and
+//              popping, the cost of the ring itself. transfer hands n items
+//              from a producer thread to the consumer, one at a time or 32
+//              at a time, next to a mutex-guarded std::queue; it needs two
+//              threads and includes starting the producer once per pass.
+
+#include "harness.h"
+
+#include "spsc_ring.h"
+
+#include <pthread.h>
+#include <queue>
+#include <sched.h>
+
+namespace {
+
+typedef spsc_ring<unsigned, 1024> ring;
+
+const unsigned kBatch = 32;
+
+ring& shared_ring() {
+  static ring r;
+  return r;
+}
+
+unsigned long push_pop(unsigned n) {
+  ring& r = shared_ring();
+  unsigned long sum = 0;
+  unsigned x = 0;
+  for (unsigned i = 0; i < n; i++) {
+    r.push(i);
+    r.pop(x);
+    sum += x;
+  }
+  bench_sink(sum);
+  return n;
+}
+
+struct job {
+  unsigned n;
+  int batched;
+};
+
+void* ring_producer(void* arg) {
+  job* j = (job*)arg;
+  ring& r = shared_ring();
+  unsigned batch[kBatch];
+  unsigned seq = 0;
+  while (seq < j->n) {
+    if (!j->batched) {
+      if (r.push(seq))
+        seq++;
+      else
+        sched_yield();
+      continue;
+    }
+    unsigned n = j->n - seq < kBatch ? j->n - seq : kBatch;
+    for (unsigned i = 0; i < n; i++) batch[i] = seq + i;
+    unsigned pushed = r.push(batch, n);
+    if (!pushed) sched_yield();
+    seq += pushed;
+  }
+  return 0;
+}
+
+unsigned long ring_transfer(unsigned n, int batched) {
+  if (bench_threads() < 2) return 0;
+  ring& r = shared_ring();
+  job j = {n, batched};
+  pthread_t thread;
+  pthread_create(&thread, 0, ring_producer, &j);
+  unsigned batch[kBatch];
+  unsigned long sum = 0;
+  unsigned got = 0;
+  while (got < n) {
+    unsigned k = batched ? r.pop(batch, kBatch) : r.pop(batch[0]);
+    if (!k) sched_yield();
+    for (unsigned i = 0; i < k; i++) sum += batch[i];
+    got += k;
+  }
+  pthread_join(thread, 0);
+  bench_sink(sum);
+  return n;
+}
+
+unsigned long transfer_single(unsigned n) { return ring_transfer(n, 0); }
+unsigned long transfer_batched(unsigned n) { return ring_transfer(n, 1); }
+
+struct locked_queue {
+  pthread_mutex_t mu;
+  std::queue<unsigned> q;
+  locked_queue() { pthread_mutex_init(&mu, 0); }
+};
+
+locked_queue& shared_queue() {
+  static locked_queue lq;
+  return lq;
+}
+
+void* queue_producer(void* arg) {
+  unsigned n = *(unsigned*)arg;
+  locked_queue& lq = shared_queue();
+  for (unsigned i = 0; i < n; i++) {
+    pthread_mutex_lock(&lq.mu);
+    lq.q.push(i);
+    pthread_mutex_unlock(&lq.mu);
+  }
+  return 0;
+}
+
+unsigned long std_transfer(unsigned n) {
+  if (bench_threads() < 2) return 0;
+  locked_queue& lq = shared_queue();
+  pthread_t thread;
+  pthread_create(&thread, 0, queue_producer, &n);
+  unsigned long sum = 0;
+  unsigned got = 0;
+  while (got < n) {
+    pthread_mutex_lock(&lq.mu);
+    int any = !lq.q.empty();
+    if (any) {
+      sum += lq.q.front();
+      lq.q.pop();
+      got++;
+    }
+    pthread_mutex_unlock(&lq.mu);
+    if (!any) sched_yield();
+  }
+  pthread_join(thread, 0);
+  bench_sink(sum);
+  return n;
+}
+
+const unsigned kLarge = 1u << 20;
+
+}  // namespace
+
+STL_BENCH("spsc_ring", "push_pop", "stl", kLarge, push_pop);
+STL_BENCH("spsc_ring", "transfer", "stl", kLarge, transfer_single);
+STL_BENCH("spsc_ring", "transfer", "stl_batch", kLarge, transfer_batched);
+STL_BENCH("spsc_ring", "transfer", "std", kLarge, std_transfer);
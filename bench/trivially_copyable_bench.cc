@@ -0,0 +1,123 @@
+// File: bench/trivially_copyable_bench.cc
+//
+// Description: vector copy, growth and middle insert/erase for PODs of 4, 16
+//              and 64 bytes, with the bulk memcpy/memmove path ("bulk"),
+//              with the same type not opted in ("per_element"), and with
+//              std::vector. pair<int, int> takes the bulk path through the
+//              pair overload of is_trivially_copyable.
+
+#include "harness.h"
+
+#include "vector.h"
+
+#include <vector>
+
+namespace {
+
+template <int N>
+struct pod {
+  unsigned v[N];
+};
+
+// The same layout, opted in to the bulk path.
+template <int N>
+struct bulk_pod {
+  unsigned v[N];
+};
+
+template <int N>
+int is_trivially_copyable(const bulk_pod<N>*) {
+  return 1;
+}
+
+template <class T>
+T make_element(unsigned i, const T*) {
+  T t;
+  for (unsigned k = 0; k < sizeof(t.v) / sizeof(t.v[0]); k++) t.v[k] = i + k;
+  return t;
+}
+
+pair<int, int> make_element(unsigned i, const pair<int, int>*) {
+  return make_pair((int)i, (int)~i);
+}
+
+template <class V>
+unsigned long pod_copy(unsigned n) {
+  static V v;
+  if (v.size() != n) {
+    v.clear();
+    for (unsigned i = 0; i < n; i++)
+      v.push_back(make_element(i, (const typename V::value_type*)0));
+  }
+  V w(v);
+  bench_sink(w.size());
+  return n;
+}
+
+// Growth by doubling, so about half of the elements are moved once more.
+template <class V>
+unsigned long pod_push_back(unsigned n) {
+  V v;
+  for (unsigned i = 0; i < n; i++)
+    v.push_back(make_element(i, (const typename V::value_type*)0));
+  bench_sink(v.size());
+  return n;
+}
+
+template <class V>
+unsigned long pod_insert_erase(unsigned n) {
+  V v;
+  for (unsigned i = 0; i < n; i++)
+    v.insert(v.begin() + i / 2,
+             make_element(i, (const typename V::value_type*)0));
+  while (v.size()) v.erase(v.begin() + v.size() / 2);
+  bench_sink(v.size());
+  return 2ul * n;
+}
+
+const unsigned kLarge = 1u << 20;
+const unsigned kQuadratic = 1u << 14;
+
+}  // namespace
+
+#define POD_BENCH(group, T)                                                 \
+  STL_BENCH(group, "copy", "bulk", kLarge, pod_copy<vector<bulk_##T> >);    \
+  STL_BENCH(group, "copy", "per_element", kLarge, pod_copy<vector<T> >);    \
+  STL_BENCH(group, "copy", "std", kLarge, pod_copy<std::vector<T> >);       \
+  STL_BENCH(group, "push_back", "bulk", kLarge,                             \
+            pod_push_back<vector<bulk_##T> >);                              \
+  STL_BENCH(group, "push_back", "per_element", kLarge,                      \
+            pod_push_back<vector<T> >);                                     \
+  STL_BENCH(group, "push_back", "std", kLarge,                              \
+            pod_push_back<std::vector<T> >);                                \
+  STL_BENCH(group, "insert_erase", "bulk", kQuadratic,                      \
+            pod_insert_erase<vector<bulk_##T> >);                           \
+  STL_BENCH(group, "insert_erase", "per_element", kQuadratic,               \
+            pod_insert_erase<vector<T> >);                                  \
+  STL_BENCH(group, "insert_erase", "std", kQuadratic,                       \
+            pod_insert_erase<std::vector<T> >)
+
+namespace {
+typedef pod<1> pod4;
+typedef bulk_pod<1> bulk_pod4;
+typedef pod<4> pod16;
+typedef bulk_pod<4> bulk_pod16;
+typedef pod<16> pod64;
+typedef bulk_pod<16> bulk_pod64;
+typedef pair<int, int> int_pair;
+}  // namespace
+
+POD_BENCH("pod4", pod4);
+POD_BENCH("pod16", pod16);
+POD_BENCH("pod64", pod64);
+
+STL_BENCH("pair", "copy", "bulk", kLarge, pod_copy<vector<int_pair> >);
+STL_BENCH("pair", "copy", "std", kLarge, pod_copy<std::vector<int_pair> >);
+STL_BENCH("pair", "push_back", "bulk", kLarge,
+          pod_push_back<vector<int_pair> >);
+STL_BENCH("pair", "push_back", "std", kLarge,
+          pod_push_back<std::vector<int_pair> >);
+STL_BENCH("pair", "insert_erase", "bulk", kQuadratic,
+          pod_insert_erase<vector<int_pair> >);
+STL_BENCH("pair", "insert_erase", "std", kQuadratic,
+          pod_insert_erase<std::vector<int_pair> >);
@@ -0,0 +1,110 @@
+// File: bench/work_stealing_bench.cc
+//
+// Description: Cost of the Chase-Lev deque operations on one thread, and
+//              throughput of work_stealing_scheduler running a binary tree
+//              of n tasks on 1 to 16 workers. Every task spawns its two
+//              children, so all work starts on worker 0 and spreads only by
+//              stealing. Worker counts above --threads are skipped; each
+//              pass includes starting the extra worker threads.
+
+#include "harness.h"
+
+#include "work_stealing_deque.h"
+
+#include <pthread.h>
+
+namespace {
+
+unsigned long push_pop(unsigned n) {
+  static work_stealing_deque<long> d(1024);
+  long x = 0, sum = 0;
+  for (unsigned i = 0; i < n; i++) d.push(i);
+  for (unsigned i = 0; i < n; i++) {
+    d.pop(x);
+    sum += x;
+  }
+  bench_sink(sum);
+  return 2ul * n;
+}
+
+unsigned long push_steal(unsigned n) {
+  static work_stealing_deque<long> d(1024);
+  long x = 0, sum = 0;
+  for (unsigned i = 0; i < n; i++) d.push(i);
+  for (unsigned i = 0; i < n; i++) {
+    d.steal(x);
+    sum += x;
+  }
+  bench_sink(sum);
+  return 2ul * n;
+}
+
+class tree_task : public ws_task {
+ public:
+  unsigned id, n;
+  tree_task* all;
+  unsigned long result;
+
+  void run(work_stealing_scheduler& sched, int worker) {
+    // A little arithmetic, so that a task is more than its scheduling.
+    unsigned long x = id;
+    for (int i = 0; i < 64; i++) x = x * 6364136223846793005ul + 1;
+    result = x;
+    for (unsigned c = 2 * id + 1; c <= 2 * id + 2 && c < n; c++)
+      sched.spawn(worker, &all[c]);
+  }
+};
+
+struct worker_arg {
+  work_stealing_scheduler* sched;
+  int self;
+};
+
+void* worker_main(void* arg) {
+  worker_arg* w = (worker_arg*)arg;
+  w->sched->run_worker(w->self);
+  return 0;
+}
+
+template <unsigned kWorkers>
+unsigned long tree(unsigned n) {
+  if (kWorkers > bench_threads()) return 0;
+  static tree_task* tasks;
+  static unsigned size;
+  if (size != n) {
+    delete[] tasks;
+    tasks = new tree_task[n];
+    size = n;
+  }
+  for (unsigned i = 0; i < n; i++) {
+    tasks[i].id = i;
+    tasks[i].n = n;
+    tasks[i].all = tasks;
+  }
+
+  work_stealing_scheduler sched(kWorkers);
+  sched.spawn(0, &tasks[0]);
+  pthread_t threads[kWorkers];
+  worker_arg args[kWorkers];
+  for (unsigned w = 1; w < kWorkers; w++) {
+    args[w].sched = &sched;
+    args[w].self = w;
+    pthread_create(&threads[w], 0, worker_main, &args[w]);
+  }
+  sched.run_worker(0);
+  for (unsigned w = 1; w < kWorkers; w++) pthread_join(threads[w], 0);
+  bench_sink(tasks[n - 1].result);
+  return n;
+}
+
+const unsigned kLarge = 1u << 20;
+
+}  // namespace
+
+STL_BENCH("ws_deque", "push_pop", "stl", kLarge, push_pop);
+STL_BENCH("ws_deque", "push_steal", "stl", kLarge, push_steal);
+STL_BENCH("ws_scheduler", "tree", "workers_1", kLarge, tree<1>);
+STL_BENCH("ws_scheduler", "tree", "workers_2", kLarge, tree<2>);
+STL_BENCH("ws_scheduler", "tree", "workers_4", kLarge, tree<4>);
+STL_BENCH("ws_scheduler", "tree", "workers_8", kLarge, tree<8>);
+STL_BENCH("ws_scheduler", "tree", "workers_16", kLarge, tree<16>);
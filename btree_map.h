@@ -0,0 +1,480 @@
+// File: btree_map.h
+//
+// Description: Ordered map as a B+-tree. Inner nodes hold only separator keys
+//              and child pointers and are sized to a few cache lines; leaves
+//              hold the key/value pairs in sorted arrays and are linked to
+//              their neighbours for in-order iteration. A lookup touches
+//              O(log_B n) nodes instead of the O(log n) scattered nodes of the
+//              red-black map, which pays off for large key sets.
+
+#ifndef _STL_BTREE_MAP_H_
+#define _STL_BTREE_MAP_H_
+
+#include "utility.h"
+
+#include <assert.h>
+
+template <class Key, class Value>
+class btree_map {
+ public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef pair<Key, Value> value_type;
+  typedef unsigned size_type;
+
+  btree_map() : root_(0), first_(0), last_(0), height_(0u), size_(0u) {}
+
+  btree_map(const btree_map& cp)
+      : root_(0), first_(0), last_(0), height_(0u), size_(0u) {
+    append(cp);
+  }
+
+  ~btree_map() { clear(); }
+
+  btree_map& operator=(const btree_map& cp) {
+    if (this != &cp) {
+      clear();
+      append(cp);
+    }
+    return *this;
+  }
+
+  void clear() {
+    clean_up(root_, height_);
+    root_ = 0;
+    first_ = last_ = 0;
+    height_ = 0;
+    size_ = 0;
+  }
+
+  size_type size() const { return size_; }
+  int empty() const { return !size_; }
+
+  mapped_type& at(const key_type& key) {
+    leaf* l = descend(key, 0, 0);
+    unsigned i = l ? leaf_lower_bound(l, key) : 0;
+    assert(l && i < l->n && !(key < l->slots()[i].first));
+    return l->slots()[i].second;
+  }
+
+  const mapped_type& at(const key_type& key) const {
+    leaf* l = descend(key, 0, 0);
+    unsigned i = l ? leaf_lower_bound(l, key) : 0;
+    assert(l && i < l->n && !(key < l->slots()[i].first));
+    return l->slots()[i].second;
+  }
+
+  void erase(const key_type& key) {
+    if (!root_) return;
+    inner* path[kMaxHeight];
+    unsigned pos[kMaxHeight];
+    leaf* l = descend(key, path, pos);
+    unsigned i = leaf_lower_bound(l, key);
+    if (i == l->n || key < l->slots()[i].first) return;
+    _raw_erase(l->slots(), l->n, i);
+    l->n--;
+    size_--;
+    rebalance_leaf(l, path, pos);
+  }
+
+ private:
+  // Node capacities in elements, derived from the node sizes in bytes.
+  enum {
+    kLeafBytes = 512,
+    kInnerBytes = 256,
+    kLeafSlots = kLeafBytes / sizeof(value_type) > 4
+                     ? kLeafBytes / sizeof(value_type)
+                     : 4,
+    kInnerSlots = kInnerBytes / (sizeof(Key) + sizeof(void*)) > 4
+                      ? kInnerBytes / (sizeof(Key) + sizeof(void*))
+                      : 4,
+    kMinLeaf = kLeafSlots / 2,
+    kMinInner = kInnerSlots / 2,
+    // Inner nodes have at least three children, so this is plenty.
+    kMaxHeight = 32
+  };
+
+  // Both node kinds have room for one element more than their capacity, so an
+  // insertion can go in first and the overfull node split afterwards.
+  struct leaf {
+    unsigned n;
+    leaf *prev, *next;
+    union {
+      char bytes[(kLeafSlots + 1) * sizeof(value_type)];
+      long double align_float;
+      long align_int;
+      void* align_ptr;
+    } buf;
+    leaf() : n(0), prev(0), next(0) {}
+    value_type* slots() { return (value_type*)buf.bytes; }
+  };
+
+  // n separator keys and n + 1 children, leaves or inner nodes depending on
+  // the level. Child i holds the keys k with keys[i - 1] <= k < keys[i].
+  struct inner {
+    unsigned n;
+    void* child[kInnerSlots + 2];
+    union {
+      char bytes[(kInnerSlots + 1) * sizeof(Key)];
+      long double align_float;
+      long align_int;
+      void* align_ptr;
+    } buf;
+    inner() : n(0) {}
+    Key* keys() { return (Key*)buf.bytes; }
+  };
+
+  // A leaf when height_ is 0.
+  void* root_;
+  leaf *first_, *last_;
+  size_type height_, size_;
+
+  void append(const btree_map& cp) {
+    for (leaf* l = cp.first_; l; l = l->next)
+      for (unsigned i = 0; i < l->n; i++)
+        try_emplace(l->slots()[i].first, l->slots()[i].second);
+  }
+
+  void clean_up(void* p, size_type height) {
+    if (!p) return;
+    if (!height) {
+      leaf* l = (leaf*)p;
+      for (unsigned i = 0; i < l->n; i++) _destroy(l->slots() + i);
+      delete l;
+      return;
+    }
+    inner* in = (inner*)p;
+    for (unsigned i = 0; i <= in->n; i++) clean_up(in->child[i], height - 1);
+    for (unsigned j = 0; j < in->n; j++) _destroy(in->keys() + j);
+    delete in;
+  }
+
+  // The searches within a node halve the range on every step whichever way
+  // the compare goes, so the half is picked with a conditional move rather
+  // than a branch that mispredicts half the time.
+
+  // Index of the child of in that covers key.
+  static unsigned child_idx(inner* in, const Key& key) {
+    unsigned n = in->n;
+    if (!n) return 0;
+    const Key* base = in->keys();
+    while (n > 1) {
+      unsigned half = n / 2;
+      base = key < base[half] ? base : base + half;
+      n -= half;
+    }
+    return (base - in->keys()) + !(key < *base);
+  }
+
+  // Index of the first pair in l whose key is not less than key.
+  static unsigned leaf_lower_bound(leaf* l, const Key& key) {
+    unsigned n = l->n;
+    if (!n) return 0;
+    const value_type* base = l->slots();
+    while (n > 1) {
+      unsigned half = n / 2;
+      base = base[half].first < key ? base + half : base;
+      n -= half;
+    }
+    return (base - l->slots()) + (base->first < key);
+  }
+
+  // Returns the leaf covering key. If path is given, path[h] and pos[h] get
+  // the inner node at depth h and the index of the child taken from it.
+  leaf* descend(const Key& key, inner** path, unsigned* pos) const {
+    void* p = root_;
+    for (size_type h = 0; p && h < height_; h++) {
+      inner* in = (inner*)p;
+      unsigned i = child_idx(in, key);
+      if (path) {
+        path[h] = in;
+        pos[h] = i;
+      }
+      p = in->child[i];
+    }
+    return (leaf*)p;
+  }
+
+  // Splits the overfull leaf l and links the new right half after it.
+  leaf* split_leaf(leaf* l) {
+    leaf* r = new leaf;
+    unsigned half = l->n / 2;
+    _raw_move(r->slots(), l->slots() + half, l->n - half);
+    r->n = l->n - half;
+    l->n = half;
+    r->prev = l;
+    r->next = l->next;
+    if (l->next)
+      l->next->prev = r;
+    else
+      last_ = r;
+    l->next = r;
+    return r;
+  }
+
+  // Inserts separator sep and its right child into the inner node at depth h
+  // of path, splitting overfull nodes up to a new root as needed.
+  void insert_up(inner** path, unsigned* pos, int h, Key sep, void* right) {
+    for (; h >= 0; h--) {
+      inner* in = path[h];
+      unsigned i = pos[h];
+      _raw_insert(in->keys(), in->n, i, sep);
+      for (unsigned c = in->n + 1; c > i + 1; c--)
+        in->child[c] = in->child[c - 1];
+      in->child[i + 1] = right;
+      if (++in->n <= kInnerSlots) return;
+
+      // The middle key moves up, the keys after it go to the new node.
+      inner* r = new inner;
+      unsigned mid = in->n / 2;
+      r->n = in->n - mid - 1;
+      _raw_move(r->keys(), in->keys() + mid + 1, r->n);
+      for (unsigned j = 0; j <= r->n; j++) r->child[j] = in->child[mid + 1 + j];
+      sep = in->keys()[mid];
+      _destroy(in->keys() + mid);
+      in->n = mid;
+      right = r;
+    }
+    inner* root = new inner;
+    _construct(root->keys(), sep);
+    root->child[0] = root_;
+    root->child[1] = right;
+    root->n = 1;
+    root_ = root;
+    height_++;
+  }
+
+  // Removes key k and child k + 1 from in.
+  static void remove_from_inner(inner* in, unsigned k) {
+    _raw_erase(in->keys(), in->n, k);
+    for (unsigned c = k + 1; c < in->n; c++) in->child[c] = in->child[c + 1];
+    in->n--;
+  }
+
+  // Refills the leaf l from a sibling or merges it into one after an erase.
+  void rebalance_leaf(leaf* l, inner** path, unsigned* pos) {
+    if (!height_) {
+      if (!l->n) {
+        delete l;
+        root_ = first_ = last_ = 0;
+      }
+      return;
+    }
+    if (l->n >= kMinLeaf) return;
+    inner* parent = path[height_ - 1];
+    unsigned ci = pos[height_ - 1];
+    leaf* left;
+    leaf* right;
+    if (ci > 0) {
+      left = (leaf*)parent->child[ci - 1];
+      right = l;
+      if (left->n > kMinLeaf) {
+        _raw_insert(l->slots(), l->n, 0, left->slots()[left->n - 1]);
+        l->n++;
+        _destroy(left->slots() + --left->n);
+        parent->keys()[ci - 1] = l->slots()[0].first;
+        return;
+      }
+      ci--;
+    } else {
+      left = l;
+      right = (leaf*)parent->child[1];
+      if (right->n > kMinLeaf) {
+        _construct(l->slots() + l->n++, right->slots()[0]);
+        _raw_erase(right->slots(), right->n--, 0);
+        parent->keys()[0] = right->slots()[0].first;
+        return;
+      }
+    }
+    // Merge right into left; the separator between them goes away.
+    _raw_move(left->slots() + left->n, right->slots(), right->n);
+    left->n += right->n;
+    left->next = right->next;
+    if (right->next)
+      right->next->prev = left;
+    else
+      last_ = left;
+    delete right;
+    remove_from_inner(parent, ci);
+    rebalance_inner(path, pos, height_ - 1);
+  }
+
+  // Same as rebalance_leaf for the inner node at depth h of path, which lost
+  // a key. The root only goes away once it has a single child left.
+  void rebalance_inner(inner** path, unsigned* pos, size_type h) {
+    for (;; h--) {
+      inner* in = path[h];
+      if (!h) {
+        if (!in->n) {
+          root_ = in->child[0];
+          delete in;
+          height_--;
+        }
+        return;
+      }
+      if (in->n >= kMinInner) return;
+      inner* parent = path[h - 1];
+      unsigned ci = pos[h - 1];
+      inner* left;
+      inner* right;
+      if (ci > 0) {
+        left = (inner*)parent->child[ci - 1];
+        right = in;
+        if (left->n > kMinInner) {
+          // Rotate the separator down and the left's last key up.
+          _raw_insert(in->keys(), in->n, 0, parent->keys()[ci - 1]);
+          for (unsigned c = in->n + 1; c > 0; c--)
+            in->child[c] = in->child[c - 1];
+          in->child[0] = left->child[left->n];
+          in->n++;
+          parent->keys()[ci - 1] = left->keys()[left->n - 1];
+          _destroy(left->keys() + --left->n);
+          return;
+        }
+        ci--;
+      } else {
+        left = in;
+        right = (inner*)parent->child[1];
+        if (right->n > kMinInner) {
+          _construct(in->keys() + in->n, parent->keys()[0]);
+          in->child[++in->n] = right->child[0];
+          parent->keys()[0] = right->keys()[0];
+          _raw_erase(right->keys(), right->n, 0);
+          for (unsigned c = 0; c < right->n; c++)
+            right->child[c] = right->child[c + 1];
+          right->n--;
+          return;
+        }
+      }
+      // Merge: left's keys, the separator, then right's keys.
+      _construct(left->keys() + left->n, parent->keys()[ci]);
+      _raw_move(left->keys() + left->n + 1, right->keys(), right->n);
+      for (unsigned j = 0; j <= right->n; j++)
+        left->child[left->n + 1 + j] = right->child[j];
+      left->n += 1 + right->n;
+      delete right;
+      remove_from_inner(parent, ci);
+    }
+  }
+
+ public:
+  class iterator {
+   public:
+    iterator() : owner_(0), l_(0), idx_(0) {}
+
+    void operator++() { increment(); }
+
+    void operator++(int k) { increment(); }
+
+    // Decrementing end() moves to the last element.
+    void operator--() { decrement(); }
+
+    void operator--(int k) { decrement(); }
+
+    value_type& operator*() {
+      assert(l_);
+      return l_->slots()[idx_];
+    }
+
+    value_type* operator->() { return l_->slots() + idx_; }
+
+    int operator==(const iterator& rhs) const {
+      return l_ == rhs.l_ && idx_ == rhs.idx_;
+    }
+
+    int operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+   private:
+    typedef btree_map<key_type, mapped_type>::leaf leaf;
+
+    btree_map<key_type, mapped_type>* owner_;
+    leaf* l_;
+    unsigned idx_;
+
+    iterator(btree_map<key_type, mapped_type>* owner, leaf* l, unsigned idx)
+        : owner_(owner), l_(l), idx_(idx) {
+      // One past a leaf's last pair is the next leaf's first.
+      if (l_ && idx_ == l_->n) {
+        l_ = l_->next;
+        idx_ = 0;
+      }
+    }
+
+    void increment() {
+      if (++idx_ < l_->n) return;
+      l_ = l_->next;
+      idx_ = 0;
+    }
+
+    void decrement() {
+      if (l_ && idx_) {
+        idx_--;
+        return;
+      }
+      l_ = l_ ? l_->prev : owner_->last_;
+      idx_ = l_->n - 1;
+    }
+
+    friend class btree_map<key_type, mapped_type>;
+  };
+
+  iterator begin() { return iterator(this, first_, 0); }
+
+  iterator end() { return iterator(this, 0, 0); }
+
+  iterator find(const key_type& key) {
+    leaf* l = descend(key, 0, 0);
+    if (!l) return end();
+    unsigned i = leaf_lower_bound(l, key);
+    if (i == l->n || key < l->slots()[i].first) return end();
+    return iterator(this, l, i);
+  }
+
+  // First element whose key is not less than key.
+  iterator lower_bound(const key_type& key) {
+    leaf* l = descend(key, 0, 0);
+    if (!l) return end();
+    return iterator(this, l, leaf_lower_bound(l, key));
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+
+  // Inserts key with a default value unless it is already there; .second is
+  // nonzero if the key was inserted.
+  pair<iterator, int> try_emplace(const key_type& key) {
+    return try_emplace(key, mapped_type());
+  }
+
+  pair<iterator, int> try_emplace(const key_type& key, const mapped_type& val) {
+    if (!root_) root_ = first_ = last_ = new leaf;
+    inner* path[kMaxHeight];
+    unsigned pos[kMaxHeight];
+    leaf* l = descend(key, path, pos);
+    unsigned i = leaf_lower_bound(l, key);
+    if (i < l->n && !(key < l->slots()[i].first))
+      return make_pair(iterator(this, l, i), 0);
+    _raw_insert(l->slots(), l->n, i, value_type(key, val));
+    size_++;
+    if (++l->n > kLeafSlots) {
+      leaf* r = split_leaf(l);
+      insert_up(path, pos, (int)height_ - 1, r->slots()[0].first, r);
+      if (i >= l->n) {
+        i -= l->n;
+        l = r;
+      }
+    }
+    return make_pair(iterator(this, l, i), 1);
+  }
+
+  // Inserts key or overwrites its value; .second is nonzero if the key was
+  // inserted.
+  pair<iterator, int> insert(const key_type& key, const mapped_type& val) {
+    pair<iterator, int> res = try_emplace(key, val);
+    if (!res.second) res.first->second = val;
+    return res;
+  }
+};
+
+#endif  // _STL_BTREE_MAP_H_
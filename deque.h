@@ -0,0 +1,222 @@
+// File: deque.h
+//
+// Description: Double-ended queue stored in one contiguous circular buffer.
+//              The capacity is a power of two, so wrapping is a mask, and it
+//              doubles when full: push and pop at either end are amortized
+//              O(1) and never allocate per element.
+
+#ifndef _STL_DEQUE_H_
+#define _STL_DEQUE_H_
+
+#include "algo.h"
+#include "allocator.h"
+#include "utility.h"
+
+#include <assert.h>
+#include <string.h>
+
+template <class T>
+class deque {
+ public:
+  typedef T value_type;
+  typedef unsigned size_type;
+
+  deque() : alloc_(0), buf_(0), cap_(0u), head_(0u), size_(0u) {}
+
+  // Allocates through alloc, see allocator.h.
+  deque(allocator& alloc)
+      : alloc_(&alloc), buf_(0), cap_(0u), head_(0u), size_(0u) {}
+
+  // The copy allocates like cp; assignment keeps the target's allocator.
+  deque(const deque& cp)
+      : alloc_(cp.alloc_), buf_(0), cap_(0u), head_(0u), size_(0u) {
+    append(cp);
+  }
+
+  ~deque() {
+    clear();
+    _deallocate_bytes(alloc_, buf_, cap_ * sizeof(value_type));
+  }
+
+  deque& operator=(const deque& cp) {
+    if (this != &cp) {
+      clear();
+      append(cp);
+    }
+    return *this;
+  }
+
+  value_type& operator[](size_type idx) {
+    assert(idx < size_);
+    return buf_[(head_ + idx) & (cap_ - 1)];
+  }
+
+  const value_type& operator[](size_type idx) const {
+    assert(idx < size_);
+    return buf_[(head_ + idx) & (cap_ - 1)];
+  }
+
+  value_type& front() {
+    assert(size_);
+    return buf_[head_];
+  }
+
+  const value_type& front() const {
+    assert(size_);
+    return buf_[head_];
+  }
+
+  value_type& back() {
+    assert(size_);
+    return buf_[(head_ + size_ - 1) & (cap_ - 1)];
+  }
+
+  const value_type& back() const {
+    assert(size_);
+    return buf_[(head_ + size_ - 1) & (cap_ - 1)];
+  }
+
+  size_type size() const { return size_; }
+  size_type capacity() const { return cap_; }
+  int empty() const { return !size_; }
+
+  void clear() {
+    while (size_) pop_back();
+    head_ = 0;
+  }
+
+  // Rounds cap up to a power of two.
+  void reserve(size_type cap) {
+    if (cap <= cap_) return;
+    size_type new_cap = cap_ ? cap_ : 4u;
+    while (new_cap < cap) new_cap += new_cap;
+    grow(new_cap);
+  }
+
+  void push_back(const value_type& val) {
+    if (size_ == cap_) {
+      // val may live in the old buffer, so copy it before growing.
+      value_type temp(val);
+      grow(cap_ ? cap_ + cap_ : 4u);
+      _construct(buf_ + ((head_ + size_) & (cap_ - 1)), temp);
+    } else {
+      _construct(buf_ + ((head_ + size_) & (cap_ - 1)), val);
+    }
+    size_++;
+  }
+
+  void push_front(const value_type& val) {
+    if (size_ == cap_) {
+      value_type temp(val);
+      grow(cap_ ? cap_ + cap_ : 4u);
+      head_ = (head_ - 1) & (cap_ - 1);
+      _construct(buf_ + head_, temp);
+    } else {
+      head_ = (head_ - 1) & (cap_ - 1);
+      _construct(buf_ + head_, val);
+    }
+    size_++;
+  }
+
+  void pop_back() {
+    if (!size_) return;
+    size_--;
+    _destroy(buf_ + ((head_ + size_) & (cap_ - 1)));
+  }
+
+  void pop_front() {
+    if (!size_) return;
+    _destroy(buf_ + head_);
+    head_ = (head_ + 1) & (cap_ - 1);
+    size_--;
+  }
+
+  int operator==(const deque& rhs) const {
+    if (size_ != rhs.size_) return 0;
+    for (size_type i = 0; i < size_; i++)
+      if ((*this)[i] != rhs[i]) return 0;
+    return 1;
+  }
+
+  int operator!=(const deque& rhs) const { return !(*this == rhs); }
+
+  // Null when the deque uses global new and delete.
+  allocator* get_allocator() const { return alloc_; }
+
+ private:
+  allocator* alloc_;
+  value_type* buf_;
+  size_type cap_, head_, size_;
+
+  void append(const deque& cp) {
+    reserve(cp.size_);
+    for (size_type i = 0; i < cp.size_; i++) push_back(cp[i]);
+  }
+
+  // Moves the elements to a new buffer of cap slots, unwrapped from index 0.
+  void grow(size_type cap) {
+    value_type* temp =
+        (value_type*)_allocate_bytes(alloc_, cap * sizeof(value_type));
+    // The live elements are [head_, cap_) followed by [0, tail).
+    size_type first = min(size_, cap_ - head_);
+    if (!size_) {
+      // Nothing to move, and buf_ may still be null.
+    } else if (is_trivially_copyable(buf_)) {
+      memcpy((void*)temp, (const void*)(buf_ + head_),
+             first * sizeof(value_type));
+      memcpy((void*)(temp + first), (const void*)buf_,
+             (size_ - first) * sizeof(value_type));
+    } else {
+      for (size_type i = 0; i < size_; i++) {
+        value_type* p = buf_ + ((head_ + i) & (cap_ - 1));
+        _construct(temp + i, *p);
+        _destroy(p);
+      }
+    }
+    _deallocate_bytes(alloc_, buf_, cap_ * sizeof(value_type));
+    buf_ = temp;
+    cap_ = cap;
+    head_ = 0;
+  }
+
+ public:
+  class iterator {
+   public:
+    iterator() : owner_(0), idx_(0) {}
+
+    void operator++() { idx_++; }
+
+    void operator++(int k) { idx_++; }
+
+    void operator--() { idx_--; }
+
+    void operator--(int k) { idx_--; }
+
+    value_type& operator*() { return (*owner_)[idx_]; }
+
+    value_type* operator->() { return &(*owner_)[idx_]; }
+
+    int operator==(const iterator& rhs) const {
+      if (!owner_) return 0;
+      if (owner_ != rhs.owner_) return 0;
+      return idx_ == rhs.idx_;
+    }
+
+    int operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+   private:
+    deque<value_type>* owner_;
+    size_type idx_;
+
+    iterator(deque<value_type>* owner, size_type idx)
+        : owner_(owner), idx_(idx) {}
+
+    friend class deque<value_type>;
+  };
+
+  iterator begin() { return iterator(this, 0); }
+
+  iterator end() { return iterator(this, size_); }
+};
+
+#endif  // _STL_DEQUE_H_
@@ -0,0 +1,150 @@
+// File: flat_map.h
+//
+// Description: Ordered map kept as a sorted vector of pairs. Lookups are a
+//              binary search over contiguous memory, so tables that are built
+//              once and then mostly read are faster and smaller than in map.
+//              Inserting or erasing a single key shifts the tail, O(size).
+
+#ifndef _STL_FLAT_MAP_H_
+#define _STL_FLAT_MAP_H_
+
+#include "algo.h"
+#include "utility.h"
+#include "vector.h"
+
+#include <assert.h>
+
+// Orders pairs by key alone.
+template <class Key, class Value>
+struct _flat_map_key_less {
+  int operator()(const pair<Key, Value>& lhs,
+                 const pair<Key, Value>& rhs) const {
+    return lhs.first < rhs.first;
+  }
+};
+
+template <class Key, class Value>
+class flat_map {
+ public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef pair<Key, Value> value_type;
+  typedef unsigned size_type;
+  typedef vector<value_type>::iterator iterator;
+
+  flat_map() : v_() {}
+
+  // Allocates the element array through alloc, see allocator.h.
+  flat_map(allocator& alloc) : v_(alloc) {}
+
+  // Bulk construction from unsorted pairs: one stable sort, then duplicates
+  // are dropped. Of several pairs with the same key the first one survives.
+  flat_map(const vector<value_type>& items) : v_(items) { sort_unique(); }
+
+  void assign(const vector<value_type>& items) {
+    v_ = items;
+    sort_unique();
+  }
+
+  void clear() { v_.clear(); }
+
+  void reserve(size_type cap) { v_.reserve(cap); }
+
+  size_type size() const { return v_.size(); }
+  int empty() const { return v_.empty(); }
+
+  // Null when the map uses global new and delete.
+  allocator* get_allocator() const { return v_.get_allocator(); }
+
+  mapped_type& at(const key_type& key) {
+    size_type idx = lower_bound_idx(key);
+    assert(idx < v_.size() && !(key < v_[idx].first));
+    return v_[idx].second;
+  }
+
+  const mapped_type& at(const key_type& key) const {
+    size_type idx = lower_bound_idx(key);
+    assert(idx < v_.size() && !(key < v_[idx].first));
+    return v_[idx].second;
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+
+  iterator begin() { return v_.begin(); }
+
+  iterator end() { return v_.end(); }
+
+  // First element whose key is not less than key.
+  iterator lower_bound(const key_type& key) {
+    return v_.begin() + lower_bound_idx(key);
+  }
+
+  iterator find(const key_type& key) {
+    size_type idx = lower_bound_idx(key);
+    if (idx == v_.size() || key < v_[idx].first) return v_.end();
+    return v_.begin() + idx;
+  }
+
+  // Inserts key with a default value unless it is already there; .second is
+  // nonzero if the key was inserted.
+  pair<iterator, int> try_emplace(const key_type& key) {
+    return try_emplace(key, mapped_type());
+  }
+
+  pair<iterator, int> try_emplace(const key_type& key, const mapped_type& val) {
+    size_type idx = lower_bound_idx(key);
+    if (idx < v_.size() && !(key < v_[idx].first))
+      return make_pair(v_.begin() + idx, 0);
+    return make_pair(v_.insert(v_.begin() + idx, make_pair(key, val)), 1);
+  }
+
+  // Inserts key or overwrites its value; .second is nonzero if the key was
+  // inserted.
+  pair<iterator, int> insert(const key_type& key, const mapped_type& val) {
+    pair<iterator, int> res = try_emplace(key, val);
+    if (!res.second) res.first->second = val;
+    return res;
+  }
+
+  void erase(const key_type& key) {
+    iterator it = find(key);
+    if (it != v_.end()) v_.erase(it);
+  }
+
+  iterator erase(iterator pos) { return v_.erase(pos); }
+
+ private:
+  vector<value_type> v_;
+
+  // The search halves n on every step whichever way the compare goes, so the
+  // loop runs a fixed number of times and the compiler can pick the half
+  // with a conditional move instead of a branch that mispredicts half the
+  // time.
+  size_type lower_bound_idx(const key_type& key) const {
+    size_type n = v_.size();
+    if (!n) return 0;
+    const value_type* base = v_.data();
+    while (n > 1) {
+      size_type half = n / 2;
+      base = base[half].first < key ? base + half : base;
+      n -= half;
+    }
+    return (base - v_.data()) + (base->first < key);
+  }
+
+  void sort_unique() {
+    stable_sort(v_.begin(), v_.end(), _flat_map_key_less<Key, Value>());
+
+    size_type n = 0;
+    for (size_type i = 0; i < v_.size(); i++) {
+      if (n && !(v_[n - 1].first < v_[i].first)) continue;
+      if (n != i) v_[n] = v_[i];
+      n++;
+    }
+    v_.erase(v_.begin() + n, v_.end());
+  }
+};
+
+#endif  // _STL_FLAT_MAP_H_
@@ -0,0 +1,50 @@
+// File: hash.h
+//
+// Description: Hash functions for the hashed containers. A key type is made
+//              hashable by declaring an overload of hash_value for it before
+//              the container is used, e.g.
+//                unsigned hash_value(const point& p) {
+//                  return hash_value(p.x) * 31 + hash_value(p.y);
+//                }
+//              The containers mix the result themselves, so a cheap function
+//              (even the identity) is fine as long as distinct keys tend to
+//              give distinct values.
+
+#ifndef _STL_HASH_H_
+#define _STL_HASH_H_
+
+#include "utility.h"
+
+inline unsigned hash_value(char x) { return (unsigned char)x; }
+inline unsigned hash_value(signed char x) { return (unsigned char)x; }
+inline unsigned hash_value(unsigned char x) { return x; }
+inline unsigned hash_value(short x) { return (unsigned short)x; }
+inline unsigned hash_value(unsigned short x) { return x; }
+inline unsigned hash_value(int x) { return (unsigned)x; }
+inline unsigned hash_value(unsigned x) { return x; }
+
+// Folds the upper half in, long is wider than unsigned on both BCC and LP64.
+inline unsigned hash_value(unsigned long x) {
+  return (unsigned)(x ^ (x >> (8 * sizeof(unsigned))));
+}
+
+inline unsigned hash_value(long x) { return hash_value((unsigned long)x); }
+
+template <class T>
+unsigned hash_value(T* p) {
+  return hash_value((unsigned long)p);
+}
+
+template <class T1, class T2>
+unsigned hash_value(const pair<T1, T2>& x) {
+  return hash_value(x.first) * 31u + hash_value(x.second);
+}
+
+// Spreads a hash over the top bits of a 32-bit word (Fibonacci hashing) and
+// returns the top bits of it, 0 < bits <= 32.
+inline unsigned _hash_index(unsigned h, unsigned bits) {
+  unsigned long x = ((unsigned long)h * 2654435769UL) & 0xFFFFFFFFUL;
+  return (unsigned)(x >> (32 - bits));
+}
+
+#endif  // _STL_HASH_H_
@@ -0,0 +1,103 @@
+// File: instrument.h
+//
+// Description: Opt-in operation counters for vector, map, list and the heap
+//              routines in algo.h. Define STL_INSTRUMENT before including
+//              any of them to turn the counters on; otherwise the counting
+//              macros expand to nothing and the containers carry no extra
+//              members. The counters are plain integers, and even lookups
+//              write them, so an instrumented build must use the containers
+//              from one thread at a time.
+
+#ifndef _STL_INSTRUMENT_H_
+#define _STL_INSTRUMENT_H_
+
+#ifdef STL_INSTRUMENT
+
+#include <stdio.h>
+
+// One set of counters, of which each kind of container uses the fields that
+// apply to it. Containers keep one per instance, returned by their stats(),
+// and every count is also added to the per-kind total in the registry below.
+struct container_stats {
+  // vector: buffers allocated and freed, bytes allocated, buffers replaced
+  // by a larger or smaller one, and elements copied (including the ones
+  // carried over on a reallocation).
+  unsigned long allocs, frees, bytes, reallocs, copies;
+  // list: nodes allocated; freed nodes are counted in frees.
+  unsigned long node_allocs;
+  // map: rotations and color flips while rebalancing, and lookups with the
+  // total number of levels they descended, so depth / descents is the
+  // average depth.
+  unsigned long rotations, flips, descents, depth;
+  // Heap routines: comparisons, and elements moved into a hole, which is
+  // what a swap-based heap would count as swaps.
+  unsigned long compares, moves;
+
+  container_stats() { reset(); }
+
+  void reset() {
+    allocs = frees = bytes = reallocs = copies = 0;
+    node_allocs = 0;
+    rotations = flips = descents = depth = 0;
+    compares = moves = 0;
+  }
+};
+
+enum stats_kind {
+  stats_vector,
+  stats_list,
+  stats_map,
+  stats_heap,
+  stats_kinds
+};
+
+// The totals live in a class template so that a header can define them: the
+// linker keeps one copy however many translation units include it.
+template <class T>
+struct _stats_registry {
+  static container_stats totals[stats_kinds];
+};
+
+template <class T>
+container_stats _stats_registry<T>::totals[stats_kinds];
+
+// The running total for every container of the given kind. It is shared by
+// all of them, so even separate containers on separate threads race on it.
+inline container_stats& stats_total(stats_kind kind) {
+  return _stats_registry<int>::totals[kind];
+}
+
+inline void reset_stats() {
+  for (int i = 0; i < stats_kinds; i++) stats_total((stats_kind)i).reset();
+}
+
+// Writes the totals in a line-per-kind key=value format.
+inline void dump_stats(FILE* out) {
+  const container_stats& v = stats_total(stats_vector);
+  fprintf(out,
+          "vector allocs=%lu frees=%lu bytes=%lu reallocs=%lu copies=%lu\n",
+          v.allocs, v.frees, v.bytes, v.reallocs, v.copies);
+  const container_stats& l = stats_total(stats_list);
+  fprintf(out, "list node_allocs=%lu frees=%lu\n", l.node_allocs, l.frees);
+  const container_stats& m = stats_total(stats_map);
+  fprintf(out, "map rotations=%lu flips=%lu descents=%lu depth=%lu\n",
+          m.rotations, m.flips, m.descents, m.depth);
+  const container_stats& h = stats_total(stats_heap);
+  fprintf(out, "heap compares=%lu moves=%lu\n", h.compares, h.moves);
+}
+
+// Adds n to field in the container's own stats and in the total for kind.
+#define _STL_COUNT(stats, kind, field, n) \
+  ((stats).field += (n), stats_total(kind).field += (n))
+
+// For code that has no container, such as the heap routines.
+#define _STL_COUNT_TOTAL(kind, field, n) (stats_total(kind).field += (n))
+
+#else
+
+#define _STL_COUNT(stats, kind, field, n) ((void)0)
+#define _STL_COUNT_TOTAL(kind, field, n) ((void)0)
+
+#endif  // STL_INSTRUMENT
+
+#endif  // _STL_INSTRUMENT_H_
@@ -0,0 +1,188 @@
+// File: intrusive_list.h
+//
+// Description: Doubly linked list whose links live inside the elements. A type
+//              is made linkable by deriving from list_hook; the list never
+//              allocates, and an element can unlink itself in O(1). An element
+//              can be on at most one intrusive_list at a time and the list
+//              doesn't own it: it must outlive its membership.
+
+#ifndef _STL_INTRUSIVE_LIST_H_
+#define _STL_INTRUSIVE_LIST_H_
+
+#include <assert.h>
+
+struct list_hook {
+  list_hook() : prev_link(0), next_link(0) {}
+
+  // Copies start out unlinked, the links belong to the original.
+  list_hook(const list_hook&) : prev_link(0), next_link(0) {}
+  list_hook& operator=(const list_hook&) { return *this; }
+
+  ~list_hook() { assert(!is_linked()); }
+
+  int is_linked() const { return next_link != 0; }
+
+  // Used by intrusive_list, which also keeps the element count. Unlink through
+  // intrusive_list::erase() instead.
+  void link_before(list_hook* pos) {
+    prev_link = pos->prev_link;
+    next_link = pos;
+    pos->prev_link->next_link = this;
+    pos->prev_link = this;
+  }
+
+  void unlink() {
+    prev_link->next_link = next_link;
+    next_link->prev_link = prev_link;
+    prev_link = next_link = 0;
+  }
+
+  list_hook* prev_link;
+  list_hook* next_link;
+};
+
+// T must derive from list_hook.
+template <class T>
+class intrusive_list {
+ public:
+  typedef T value_type;
+  typedef unsigned size_type;
+
+  intrusive_list() : size_(0u) {
+    head_.prev_link = head_.next_link = &head_;
+  }
+
+  // Unlinks the remaining elements, it doesn't destroy them.
+  ~intrusive_list() {
+    clear();
+    head_.prev_link = head_.next_link = 0;
+  }
+
+  value_type& front() {
+    assert(size_);
+    return *(value_type*)head_.next_link;
+  }
+
+  const value_type& front() const {
+    assert(size_);
+    return *(const value_type*)head_.next_link;
+  }
+
+  value_type& back() {
+    assert(size_);
+    return *(value_type*)head_.prev_link;
+  }
+
+  const value_type& back() const {
+    assert(size_);
+    return *(const value_type*)head_.prev_link;
+  }
+
+  size_type size() const { return size_; }
+
+  int empty() const { return !size_; }
+
+  void clear() {
+    while (size_) pop_front();
+  }
+
+  void push_back(value_type& val) { link(&val, &head_); }
+
+  void push_front(value_type& val) { link(&val, head_.next_link); }
+
+  void pop_back() {
+    if (!size_) return;
+    head_.prev_link->unlink();
+    size_--;
+  }
+
+  void pop_front() {
+    if (!size_) return;
+    head_.next_link->unlink();
+    size_--;
+  }
+
+  // val must be on this list.
+  void erase(value_type& val) {
+    list_hook* hook = &val;
+    assert(hook->is_linked());
+    hook->unlink();
+    size_--;
+  }
+
+ private:
+  list_hook head_;
+  size_type size_;
+
+  // Not copyable: the elements can only be linked into one list.
+  intrusive_list(const intrusive_list&);
+  intrusive_list& operator=(const intrusive_list&);
+
+  void link(list_hook* hook, list_hook* pos) {
+    assert(!hook->is_linked());
+    hook->link_before(pos);
+    size_++;
+  }
+
+ public:
+  class iterator {
+   public:
+    iterator() : p(0), owner(0) {}
+
+    void operator++() { p = p->next_link; }
+
+    void operator++(int k) { p = p->next_link; }
+
+    void operator--() { p = p->prev_link; }
+
+    void operator--(int k) { p = p->prev_link; }
+
+    value_type& operator*() {
+      assert(p != &owner->head_);
+      return *(value_type*)p;
+    }
+
+    value_type* operator->() {
+      assert(p != &owner->head_);
+      return (value_type*)p;
+    }
+
+    int operator==(const iterator& rhs) const {
+      if (!owner) return 0;
+      if (owner != rhs.owner) return 0;
+      return (p == rhs.p);
+    }
+
+    int operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+   private:
+    list_hook* p;
+
+    intrusive_list<value_type>* owner;
+    iterator(intrusive_list<value_type>* owner, list_hook* p)
+        : p(p), owner(owner) {}
+
+    friend class intrusive_list<value_type>;
+  };
+
+  iterator begin() { return iterator(this, head_.next_link); }
+
+  iterator end() { return iterator(this, &head_); }
+
+  // Inserts val before pos.
+  iterator insert(iterator pos, value_type& val) {
+    link(&val, pos.p);
+    return iterator(this, &val);
+  }
+
+  // Returns the iterator following the unlinked element.
+  iterator erase(iterator pos) {
+    assert(pos.p != &head_);
+    list_hook* next = pos.p->next_link;
+    pos.p->unlink();
+    size_--;
+    return iterator(this, next);
+  }
+};
+
+#endif  // _STL_INTRUSIVE_LIST_H_
@@ -5,6 +5,10 @@
 #ifndef _STL_LIST_H_
 #define _STL_LIST_H_
 
+#include "allocator.h"
+#include "instrument.h"
+#include "utility.h"
+
 #include <assert.h>
 
 template <class T>
@@ -13,9 +17,26 @@ class list {
   typedef T value_type;
   typedef unsigned size_type;
 
-  list() : head_(0), tail_(0), size_(0u) {}
+  list() : alloc_(0), head_(0), tail_(0), size_(0u) {}
+
+  // Allocates the nodes through alloc, see allocator.h.
+  list(allocator& alloc) : alloc_(&alloc), head_(0), tail_(0), size_(0u) {}
+
+  // The copy allocates like cp; assignment keeps the target's allocator.
+  list(const list& cp) : alloc_(cp.alloc_), head_(0), tail_(0), size_(0u) {
+    append(cp);
+  }
+
   ~list() { clear(); }
 
+  list& operator=(const list& cp) {
+    if (this != &cp) {
+      clear();
+      append(cp);
+    }
+    return *this;
+  }
+
   value_type& front() {
     assert(size_);
     return head_->val;
@@ -40,47 +61,32 @@ class list {
 
   int empty() const { return !size_; }
 
+  // O(1) when the nodes come from a monotonic allocator and the elements
+  // need no destructor: the memory goes back with the allocator.
   void clear() {
+    if (_is_monotonic(alloc_) && is_trivially_copyable((value_type*)0))
+      head_ = 0;
     while (head_) {
       pnode temp = head_;
       head_ = head_->next;
-      delete temp;
+      free_node(temp);
     }
     tail_ = 0;
     size_ = 0;
   }
 
-  void push_back(const value_type& val) {
-    pnode temp = new node(val);
-    if (!size_++)
-      head_ = tail_ = temp;
-    else {
-      tail_->next = temp;
-      tail_ = temp;
-    }
-  }
+  void push_back(const value_type& val) { link(make_node(val), 0); }
 
-  void push_front(const value_type& val) {
-    head_ = new node(val, head_);
-    if (!size_++) tail_ = head_;
-  }
+  void push_front(const value_type& val) { link(make_node(val), head_); }
 
-  // O(size)
   void pop_back() {
     if (!size_) return;
-    pnode* p = &head_;
-    while ((*p)->next) p = &((*p)->next);
-    delete (*p);
-    *p = 0;
-    if (!--size_) head_ = tail_ = 0;
+    free_node(unlink(tail_));
   }
 
   void pop_front() {
     if (!size_) return;
-    pnode temp = head_;
-    head_ = head_->next;
-    delete temp;
-    if (!--size_) head_ = tail_ = 0;
+    free_node(unlink(head_));
   }
 
   int operator==(const list& rhs) const {
@@ -92,21 +98,120 @@ class list {
 
   int operator!=(const list& rhs) const { return !(*this == rhs); }
 
+  // Null when the list uses global new and delete.
+  allocator* get_allocator() const { return alloc_; }
+
+  // The bytes of one node, for sizing a node_pool.
+  static size_type node_size() { return sizeof(node); }
+
+#ifdef STL_INSTRUMENT
+  // The counters of this list since it was constructed, see instrument.h.
+  // Spliced nodes are counted by the list that allocated them.
+  container_stats stats() const { return stats_; }
+#endif
+
  private:
   struct node {
-    node(const value_type& val, node* next = 0) : val(val), next(next) {}
+    node(const value_type& val) : val(val), prev(0), next(0) {}
     value_type val;
+    node* prev;
     node* next;
   };
   typedef node* pnode;
 
+  allocator* alloc_;
   pnode head_, tail_;
   unsigned size_;
+#ifdef STL_INSTRUMENT
+  container_stats stats_;
+#endif
+
+  pnode make_node(const value_type& val) {
+    _STL_COUNT(stats_, stats_list, node_allocs, 1);
+    return new (_allocate_bytes(alloc_, sizeof(node))) node(val);
+  }
+
+  void free_node(pnode p) {
+    _STL_COUNT(stats_, stats_list, frees, 1);
+    p->~node();
+    _deallocate_bytes(alloc_, p, sizeof(node));
+  }
+
+  void append(const list& cp) {
+    for (pnode p = cp.head_; p; p = p->next) push_back(p->val);
+  }
+
+  // Links the detached node p before pos, or at the back if pos is null.
+  void link(pnode p, pnode pos) {
+    p->next = pos;
+    p->prev = pos ? pos->prev : tail_;
+    if (p->prev)
+      p->prev->next = p;
+    else
+      head_ = p;
+    if (pos)
+      pos->prev = p;
+    else
+      tail_ = p;
+    size_++;
+  }
+
+  // Detaches p from the list and returns it.
+  pnode unlink(pnode p) {
+    if (p->prev)
+      p->prev->next = p->next;
+    else
+      head_ = p->next;
+    if (p->next)
+      p->next->prev = p->prev;
+    else
+      tail_ = p->prev;
+    p->prev = p->next = 0;
+    size_--;
+    return p;
+  }
+
+  // Moves the run [first, last] of n nodes from other before pos. A node has
+  // to go back to the allocator it came from, so between lists with
+  // different allocators the elements are copied and the originals freed.
+  void transfer(pnode pos, list& other, pnode first, pnode last, size_type n) {
+    if (other.alloc_ != alloc_) {
+      pnode stop = last->next;
+      for (pnode p = first; p != stop;) {
+        pnode next = p->next;
+        link(make_node(p->val), pos);
+        other.free_node(other.unlink(p));
+        p = next;
+      }
+      return;
+    }
+    if (first->prev)
+      first->prev->next = last->next;
+    else
+      other.head_ = last->next;
+    if (last->next)
+      last->next->prev = first->prev;
+    else
+      other.tail_ = first->prev;
+    other.size_ -= n;
+
+    last->next = pos;
+    first->prev = pos ? pos->prev : tail_;
+    if (first->prev)
+      first->prev->next = first;
+    else
+      head_ = first;
+    if (pos)
+      pos->prev = last;
+    else
+      tail_ = last;
+    size_ += n;
+  }
 
  public:
   class iterator {
    public:
-    iterator() : owner(0), p(0) {}
+    iterator() : p(0), owner(0) {}
 
     void operator++() {
       if (p) p = p->next;
@@ -116,11 +221,21 @@ class list {
       if (p) p = p->next;
     }
 
+    // Decrementing end() moves to the last element.
+    void operator--() { p = p ? p->prev : owner->tail_; }
+
+    void operator--(int k) { p = p ? p->prev : owner->tail_; }
+
     value_type& operator*() {
       assert(p);
       return p->val;
     }
 
+    value_type* operator->() {
+      assert(p);
+      return &(p->val);
+    }
+
     int operator==(const iterator& rhs) const {
       if (!owner) return 0;
       if (owner != rhs.owner) return 0;
@@ -134,7 +249,50 @@ class list {
     pnode p;
 
     list<value_type>* owner;
-    iterator(list<value_type>* owner, const pnode& p) : owner(owner), p(p) {}
+    iterator(list<value_type>* owner, const pnode& p) : p(p), owner(owner) {}
+
+    friend class list<value_type>;
+  };
+
+  class reverse_iterator {
+   public:
+    reverse_iterator() : p(0), owner(0) {}
+
+    void operator++() {
+      if (p) p = p->prev;
+    }
+
+    void operator++(int k) {
+      if (p) p = p->prev;
+    }
+
+    value_type& operator*() {
+      assert(p);
+      return p->val;
+    }
+
+    value_type* operator->() {
+      assert(p);
+      return &(p->val);
+    }
+
+    int operator==(const reverse_iterator& rhs) const {
+      if (!owner) return 0;
+      if (owner != rhs.owner) return 0;
+      return (p == rhs.p);
+    }
+
+    int operator!=(const reverse_iterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+   private:
+    typedef list<value_type>::node* pnode;
+    pnode p;
+
+    list<value_type>* owner;
+    reverse_iterator(list<value_type>* owner, const pnode& p)
+        : p(p), owner(owner) {}
 
     friend class list<value_type>;
   };
@@ -142,6 +300,90 @@ class list {
   iterator begin() { return iterator(this, head_); }
 
   iterator end() { return iterator(this, (pnode)0); }
+
+  reverse_iterator rbegin() { return reverse_iterator(this, tail_); }
+
+  reverse_iterator rend() { return reverse_iterator(this, (pnode)0); }
+
+  // Inserts val before pos and returns an iterator to it.
+  iterator insert(iterator pos, const value_type& val) {
+    assert(pos.owner == this);
+    pnode p = make_node(val);
+    link(p, pos.p);
+    return iterator(this, p);
+  }
+
+  // Returns the iterator following the erased element.
+  iterator erase(iterator pos) {
+    assert(pos.owner == this && pos.p);
+    pnode next = pos.p->next;
+    free_node(unlink(pos.p));
+    return iterator(this, next);
+  }
+
+  iterator erase(iterator first, iterator last) {
+    while (first != last) first = erase(first);
+    return last;
+  }
+
+  // Moves all elements of other before pos. O(1), nothing is copied, unless
+  // the lists use different allocators (see transfer()).
+  void splice(iterator pos, list& other) {
+    assert(pos.owner == this);
+    if (&other == this || !other.size_) return;
+    transfer(pos.p, other, other.head_, other.tail_, other.size_);
+  }
+
+  // Moves the element at it from other before pos. O(1).
+  void splice(iterator pos, list& other, iterator it) {
+    assert(pos.owner == this && it.owner == &other && it.p);
+    if (&other == this && (pos.p == it.p || pos.p == it.p->next)) return;
+    transfer(pos.p, other, it.p, it.p, 1);
+  }
+
+  // Moves [first, last) from other before pos. O(1) within one list, otherwise
+  // O(distance) to keep both sizes right. pos mustn't be inside the range.
+  void splice(iterator pos, list& other, iterator first, iterator last) {
+    assert(pos.owner == this && first.owner == &other);
+    if (first == last) return;
+    size_type n = 0;
+    if (&other != this)
+      for (pnode p = first.p; p != last.p; p = p->next) n++;
+    transfer(pos.p, other, first.p, last.p ? last.p->prev : other.tail_, n);
+  }
+
+  // Merges the sorted list other into this sorted one by relinking nodes, or
+  // by copying them if the allocators differ. The merge is stable and leaves
+  // other empty.
+  void merge(list& other) {
+    if (&other == this) return;
+    pnode p = head_;
+    while (other.head_) {
+      while (p && !(other.head_->val < p->val)) p = p->next;
+      if (!p) {
+        transfer(0, other, other.head_, other.tail_, other.size_);
+        break;
+      }
+      pnode first = other.head_, last = first;
+      size_type n = 1;
+      while (last->next && last->next->val < p->val) {
+        last = last->next;
+        n++;
+      }
+      transfer(p, other, first, last, n);
+    }
+  }
+
+  void reverse() {
+    for (pnode p = head_; p; p = p->prev) {
+      pnode temp = p->next;
+      p->next = p->prev;
+      p->prev = temp;
+    }
+    pnode temp = head_;
+    head_ = tail_;
+    tail_ = temp;
+  }
 };
 
 #endif  // _STL_LIST_H_
@@ -8,8 +8,13 @@
 #ifndef _STL_MAP_H_
 #define _STL_MAP_H_
 
+#include "allocator.h"
+#include "instrument.h"
 #include "stack.h"
 #include "utility.h"
+#include "vector.h"
+
+#include <assert.h>
 
 template <class Key, class Value>
 class map {
@@ -18,13 +23,67 @@ class map {
   typedef Value mapped_type;
   typedef unsigned size_type;
 
-  map() : root_(0), size_(0) {}
+  map()
+      : alloc_(0),
+        root_(0),
+        rightmost_(0),
+        size_(0),
+        block_(0),
+        block_size_(0) {}
+
+  // Allocates the nodes through alloc, see allocator.h.
+  map(allocator& alloc)
+      : alloc_(&alloc),
+        root_(0),
+        rightmost_(0),
+        size_(0),
+        block_(0),
+        block_size_(0) {}
+
+  // Builds the map from items in strictly increasing key order, see assign().
+  map(const vector<pair<Key, Value> >& sorted)
+      : alloc_(0),
+        root_(0),
+        rightmost_(0),
+        size_(0),
+        block_(0),
+        block_size_(0) {
+    assign(sorted);
+  }
 
   ~map() { clear(); }
 
+  // O(1) when the nodes come from a monotonic allocator and neither keys nor
+  // values need a destructor: the memory goes back with the allocator.
   void clear() {
+    if (_is_monotonic(alloc_) && is_trivially_copyable((Key*)0) &&
+        is_trivially_copyable((Value*)0))
+      root_ = 0;
     root_ = clean_up(root_);
+    rightmost_ = 0;
     size_ = 0;
+    _deallocate_bytes(alloc_, block_, block_size_ * sizeof(node));
+    block_ = 0;
+    block_size_ = 0;
+  }
+
+  // Replaces the contents with items in strictly increasing key order. The
+  // tree is built balanced in O(n) rather than by n inserts, and all of its
+  // nodes share a single allocation.
+  void assign(const vector<pair<Key, Value> >& sorted) {
+    clear();
+    size_type n = sorted.size();
+    if (!n) return;
+    for (size_type i = 1; i < n; i++)
+      assert(compare(sorted[i - 1].first, sorted[i].first) < 0);
+    block_ = (pnode)_allocate_bytes(alloc_, n * sizeof(node));
+    block_size_ = n;
+    int bh = 0;
+    while (max_nodes(bh + 1, 2) <= n) bh++;
+    root_ = build(sorted, 0, n, bh);
+    root_->parent = 0;
+    rightmost_ = block_ + n - 1;
+    size_ = n;
   }
 
   size_type size() const { return size_; }
@@ -32,113 +91,225 @@ class map {
 
   mapped_type& at(const key_type& key) {
     // BCC 3.1 doesn't supprot const casting.
-    pnode temp = search(root_, key);
+    pnode temp = search(key);
     assert(temp);
     return temp->kv.second;
   }
 
   const mapped_type& at(const key_type& key) const {
-    pnode temp = search(root_, key);
+    pnode temp = search(key);
     assert(temp);
     return temp->kv.second;
   }
 
-  mapped_type& operator[](const key_type& key) {
-    // TODO(viktors): Optimize.
-    pnode temp = search(root_, key);
-    // Default value.
-    if (!temp) insert(key, mapped_type());
-    temp = search(root_, key);
-    return temp->kv.second;
+  // A single descent: erase(pnode, key) also handles a key that isn't there,
+  // though at about the cost of erasing one that is, rather than a lookup.
+  void erase(const key_type& key) {
+    if (!root_) return;
+    // Makes room to borrow from at the top, see erase(pnode, key).
+    if (!exists_and_red(root_->left) && !exists_and_red(root_->right))
+      root_->color = 1;
+    root_ = erase(root_, key);
+    if (root_) {
+      root_->parent = 0;
+      root_->color = 0;
+    }
+    rightmost_ = rightmost(root_);
   }
 
-  void insert(const key_type& key, const mapped_type& val) {
-    root_ = insert(root_, key, val);
+  // Checks the LLRB invariants: keys in order, no red right links, no red
+  // node with a red child, equal black height on every path, a black root,
+  // consistent parent links, and size() and the cached maximum up to date.
+  int valid() const {
+    if (root_ && (root_->color || root_->parent)) return 0;
+    size_type count = 0;
+    pnode prev = 0;
+    if (check(root_, prev, count) < 0) return 0;
+    return count == size_ && rightmost_ == rightmost(root_);
   }
 
-  void erase(const key_type& key) { root_ = erase(root_, key); }
+  // Null when the map uses global new and delete.
+  allocator* get_allocator() const { return alloc_; }
+
+  // The bytes of one node, for sizing a node_pool.
+  static size_type node_size() { return sizeof(node); }
+
+#ifdef STL_INSTRUMENT
+  // The counters of this map since it was constructed, see instrument.h.
+  container_stats stats() const { return stats_; }
+#endif
 
  private:
   struct node {
     pair<Key, Value> kv;
-    node *left, *right;
+    node *left, *right, *parent;
     int color;
     node(const Key& key, const Value& val)
-        : kv(make_pair(key, val)), left(0), right(0), color(1) {}
+        : kv(key, val), left(0), right(0), parent(0), color(1) {}
     node(const Key& key)
-        : kv(make_pair(key, Value())), left(0), right(0), color(1) {}
+        : kv(key, Value()), left(0), right(0), parent(0), color(1) {}
   };
   typedef node* pnode;
 
+  allocator* alloc_;
   pnode root_;
+  // The maximum, kept for hinted inserts at end().
+  pnode rightmost_;
   size_type size_;
+  // Raw storage for the nodes made by assign(). They are destroyed in place
+  // and the block is freed as a whole by clear().
+  pnode block_;
+  size_type block_size_;
+#ifdef STL_INSTRUMENT
+  container_stats stats_;
+
+  // For the lookups, which are const: BCC 3.1 has neither mutable nor
+  // const_cast.
+  container_stats& counters() const {
+    return ((map<Key, Value>*)this)->stats_;
+  }
+#endif
 
   int exists_and_red(pnode p) { return p && p->color; }
 
-  pnode search(pnode p, const Key& key) {
-    if (!p) return 0;
-    if (p->kv.first == key) return p;
-    if (p->kv.first < key)
-      return search(p->right, key);
-    else
-      return search(p->left, key);
+  void set_left(pnode p, pnode child) {
+    p->left = child;
+    if (child) child->parent = p;
   }
 
-  pnode& search_min(pnode& p) {
-    if (!p) return p;
-    if (p->left)
-      return search_min(p->left);
-    else
-      return p;
+  void set_right(pnode p, pnode child) {
+    p->right = child;
+    if (child) child->parent = p;
   }
 
-  pnode insert(pnode p, const Key& key, const Value& val) {
-    if (!p) {
-      size_++;
-      return new node(key, val);
+  // Keys are ordered with the three-way compare() from utility.h, called once
+  // per level on the way down.
+  pnode search(const Key& key) const {
+    pnode p = root_;
+    _STL_COUNT(counters(), stats_map, descents, 1);
+    while (p) {
+      _STL_COUNT(counters(), stats_map, depth, 1);
+      int c = compare(key, p->kv.first);
+      if (!c) return p;
+      p = c < 0 ? p->left : p->right;
     }
-    if (p->kv.first == key)
-      p->kv.second = val;
-    else if (p->kv.first > key)
-      p->left = insert(p->left, key, val);
-    else
-      p->right = insert(p->right, key, val);
+    return 0;
+  }
 
-    p = fix_up(p);
+  // Returns the node holding key, or null and the parent and side (right is
+  // nonzero for the right child) where a node for key would be linked.
+  pnode locate(const Key& key, pnode& parent, int& right) {
+    pnode p = root_;
+    parent = 0;
+    right = 0;
+    _STL_COUNT(stats_, stats_map, descents, 1);
+    while (p) {
+      _STL_COUNT(stats_, stats_map, depth, 1);
+      int c = compare(key, p->kv.first);
+      if (!c) return p;
+      parent = p;
+      right = c > 0;
+      p = right ? p->right : p->left;
+    }
+    return 0;
+  }
 
-    return p;
+  // Links the new red leaf n under parent (as the root if parent is null) and
+  // restores the invariants bottom-up with the same fix_up as the recursive
+  // top-down insert. Once two consecutive levels come out unchanged, nothing
+  // above them can change either, so the walk usually stops early: splits
+  // of a 2-3 tree are amortized O(1) per insert.
+  pnode attach(pnode parent, int right, pnode n) {
+    size_++;
+    if (!parent)
+      root_ = n;
+    else if (right)
+      set_right(parent, n);
+    else
+      set_left(parent, n);
+    if (!rightmost_ || (right && parent == rightmost_)) rightmost_ = n;
+
+    int below_changed = 1;
+    for (pnode p = parent; p;) {
+      pnode up = p->parent;
+      int on_left = up && up->left == p;
+      int color = p->color;
+      pnode q = fix_up(p);
+      if (!up)
+        root_ = q;
+      else if (on_left)
+        up->left = q;
+      else
+        up->right = q;
+      int changed = q != p || q->color != color;
+      if (!changed && !below_changed) break;
+      below_changed = changed;
+      p = up;
+    }
+    root_->color = 0;
+    return n;
   }
 
+  // On the way down the current node is kept red (or its left child is), so
+  // the leaf that is finally removed is red. The key is compared again only
+  // when a rotation replaces p. If the key isn't in the subtree the descent
+  // ends at the missing child and fix_up undoes the changes on the way back;
+  // size_ tells whether a node was removed.
   pnode erase(pnode p, const Key& key) {
-    if (!p) return 0;
-    if (key < p->kv.first) {
-      if (!exists_and_red(p->left) && p->left && !exists_and_red(p->left->left))
+    int c = compare(key, p->kv.first);
+    if (c < 0) {
+      if (!p->left) return p;
+      if (!exists_and_red(p->left) && !exists_and_red(p->left->left))
         p = move_red_left(p);
-      p->left = erase(p->left, key);
+      set_left(p, erase(p->left, key));
     } else {
-      if (exists_and_red(p->left)) p = rotate_right(p);
-      if (key == p->kv.first && !p->right) {
+      if (exists_and_red(p->left)) {
+        p = rotate_right(p);
+        c = compare(key, p->kv.first);
+      }
+      if (!p->right) {
+        if (c) return fix_up(p);
         size_--;
-        delete p;
+        free_node(p);
         return 0;
       }
-      if (!exists_and_red(p->right) && p->right &&
-          !exists_and_red(p->right->left))
-        p = move_red_right(p);
-      if (key == p->kv.first) {
-        pnode& successor = search_min(p->right);
-        p->kv.second = successor->kv.second;
-        p->kv.first = successor->kv.first;
+      if (!exists_and_red(p->right) && !exists_and_red(p->right->left)) {
+        pnode q = move_red_right(p);
+        if (q != p) c = compare(key, q->kv.first);
+        p = q;
+      }
+      if (!c) {
+        // Put the successor node in p's place, so that nodes other than the
+        // erased one (and iterators to them) stay put.
+        pnode successor;
+        set_right(p, erase_min(p->right, successor));
+        set_left(successor, p->left);
+        set_right(successor, p->right);
+        successor->color = p->color;
+        successor->parent = p->parent;
         size_--;
-        delete successor;
-        successor = 0;
+        free_node(p);
+        p = successor;
       } else
-        p->right = erase(p->right, key);
+        set_right(p, erase(p->right, key));
     }
     return fix_up(p);
   }
 
+  // Detaches the minimum of the subtree into min and returns the new subtree.
+  pnode erase_min(pnode p, pnode& min) {
+    if (!p->left) {
+      min = p;
+      return 0;
+    }
+    if (!exists_and_red(p->left) && !exists_and_red(p->left->left))
+      p = move_red_left(p);
+    set_left(p, erase_min(p->left, min));
+    return fix_up(p);
+  }
+
   pnode flip_color(pnode p) {
+    _STL_COUNT(stats_, stats_map, flips, 1);
     p->color = !p->color;
     p->left->color = !p->left->color;
     p->right->color = !p->right->color;
@@ -146,18 +317,22 @@ class map {
   }
 
   pnode rotate_left(pnode p) {
+    _STL_COUNT(stats_, stats_map, rotations, 1);
     pnode temp = p->right;
-    p->right = temp->left;
-    temp->left = p;
+    set_right(p, temp->left);
+    temp->parent = p->parent;
+    set_left(temp, p);
     temp->color = p->color;
     p->color = 1;
     return temp;
   }
 
   pnode rotate_right(pnode p) {
+    _STL_COUNT(stats_, stats_map, rotations, 1);
     pnode temp = p->left;
-    p->left = temp->right;
-    temp->right = p;
+    set_left(p, temp->right);
+    temp->parent = p->parent;
+    set_right(temp, p);
     temp->color = p->color;
     p->color = 1;
     return temp;
@@ -175,7 +350,7 @@ class map {
   pnode move_red_left(pnode p) {
     p = flip_color(p);
     if (exists_and_red(p->right->left)) {
-      p->right = rotate_right(p->right);
+      set_right(p, rotate_right(p->right));
       p = rotate_left(p);
       p = flip_color(p);
     }
@@ -194,125 +369,250 @@ class map {
     if (p) {
       p->left = clean_up(p->left);
       p->right = clean_up(p->right);
-      delete p;
+      free_node(p);
     }
     return 0;
   }
 
+  void free_node(pnode p) {
+    p->~node();
+    if (p < block_ || p >= block_ + block_size_)
+      _deallocate_bytes(alloc_, p, sizeof(node));
+  }
+
+  pnode new_node(const Key& key) {
+    return new (_allocate_bytes(alloc_, sizeof(node))) node(key);
+  }
+
+  pnode new_node(const Key& key, const Value& val) {
+    return new (_allocate_bytes(alloc_, sizeof(node))) node(key, val);
+  }
+
+  // The most nodes a tree of black height bh can hold when every node has
+  // up to ways - 1 keys: ways^bh - 1, saturated at the largest size_type.
+  static size_type max_nodes(int bh, size_type ways) {
+    size_type n = 1;
+    for (; bh > 0; bh--) {
+      if (n > (size_type)-1 / ways) return (size_type)-1;
+      n *= ways;
+    }
+    return n - 1;
+  }
+
+  // Builds a subtree of black height bh from the n items starting at first,
+  // which requires 2^bh - 1 <= n <= 3^bh - 1. Each level is a 2-node (a
+  // black node) while the two children can take the rest, and a 3-node (a
+  // black node with a red left child) otherwise; either way the children are
+  // split as evenly as possible and stay within the bounds for bh - 1.
+  pnode build(const vector<pair<Key, Value> >& sorted, size_type first,
+              size_type n, int bh) {
+    if (!n) return 0;
+    size_type most = max_nodes(bh - 1, 3);
+    pnode p;
+    if (n - 1 - (n - 1) / 2 <= most) {
+      size_type left = (n - 1) / 2;
+      p = make_node(sorted, first + left);
+      set_left(p, build(sorted, first, left, bh - 1));
+      set_right(p, build(sorted, first + left + 1, n - 1 - left, bh - 1));
+    } else {
+      size_type left = (n - 2) / 3;
+      size_type mid = (n - 2 - left) / 2;
+      pnode red = make_node(sorted, first + left);
+      red->color = 1;
+      set_left(red, build(sorted, first, left, bh - 1));
+      set_right(red, build(sorted, first + left + 1, mid, bh - 1));
+      p = make_node(sorted, first + left + 1 + mid);
+      set_left(p, red);
+      set_right(p, build(sorted, first + left + mid + 2,
+                         n - 2 - left - mid, bh - 1));
+    }
+    return p;
+  }
+
+  // Constructs the node for sorted[idx] in its slot of block_, black.
+  pnode make_node(const vector<pair<Key, Value> >& sorted, size_type idx) {
+    pnode p = new ((void*)(block_ + idx))
+        node(sorted[idx].first, sorted[idx].second);
+    p->color = 0;
+    return p;
+  }
+
+  // Returns the black height of the subtree, or -1 if it breaks an invariant.
+  // prev is the last node visited in order and count the nodes visited.
+  int check(pnode p, pnode& prev, size_type& count) const {
+    if (!p) return 0;
+    if (p->left && p->left->parent != p) return -1;
+    if (p->right && p->right->parent != p) return -1;
+    if (p->right && p->right->color) return -1;
+    if (p->color && p->left && p->left->color) return -1;
+    int left = check(p->left, prev, count);
+    if (left < 0) return -1;
+    if (prev && compare(prev->kv.first, p->kv.first) >= 0) return -1;
+    prev = p;
+    count++;
+    int right = check(p->right, prev, count);
+    if (right != left) return -1;
+    return left + !p->color;
+  }
+
+  static pnode leftmost(pnode p) {
+    if (p)
+      while (p->left) p = p->left;
+    return p;
+  }
+
+  static pnode rightmost(pnode p) {
+    if (p)
+      while (p->right) p = p->right;
+    return p;
+  }
+
+  // In-order neighbours through the parent links, amortized O(1).
+  static pnode successor(pnode p) {
+    if (p->right) return leftmost(p->right);
+    while (p->parent && p->parent->right == p) p = p->parent;
+    return p->parent;
+  }
+
+  static pnode predecessor(pnode p) {
+    if (p->left) return rightmost(p->left);
+    while (p->parent && p->parent->left == p) p = p->parent;
+    return p->parent;
+  }
+
  public:
+  // A single node pointer, null at the end: copying and comparing are O(1)
+  // and stepping never allocates.
   class iterator {
    public:
-    iterator() : owner_(0), pt_(0) {}
+    iterator() : pt_(0), owner_(0) {}
+
+    void operator++() { pt_ = successor(pt_); }
 
-    void operator++() { increment(); }
+    void operator++(int k) { pt_ = successor(pt_); }
 
-    void operator++(int k) { increment(); }
+    // Decrementing end() moves to the last element.
+    void operator--() {
+      pt_ = pt_ ? predecessor(pt_) : rightmost(owner_->root_);
+    }
+
+    void operator--(int k) {
+      pt_ = pt_ ? predecessor(pt_) : rightmost(owner_->root_);
+    }
 
-    pair<key_type, mapped_type> operator*() {
+    pair<key_type, mapped_type>& operator*() {
       assert(pt_);
       return pt_->kv;
     }
 
     pair<key_type, mapped_type>* operator->() { return &(pt_->kv); }
 
-    int operator==(const iterator& rhs) const {
-      if (!owner_) return 0;
-      if (owner_ != rhs.owner_) return 0;
-      if ((!pt_) != (!rhs.pt_)) return 0;
-      if (!pt_) return 1;
-      return (traversal_stack_ == rhs.traversal_stack_);
-    }
+    int operator==(const iterator& rhs) const { return pt_ == rhs.pt_; }
 
-    int operator!=(const iterator& rhs) const { return !(*this == rhs); }
+    int operator!=(const iterator& rhs) const { return pt_ != rhs.pt_; }
 
    private:
     typedef map<key_type, mapped_type>::node* pnode;
 
-    stack<pair<pnode, unsigned char> > traversal_stack_;
     pnode pt_;
     map<key_type, mapped_type>* owner_;
 
-    iterator(map<key_type, mapped_type>* owner, pnode root, int is_end)
-        : owner_(owner) {
-      if (!owner || !root) is_end = 1;
-      if (!is_end) {
-        traversal_stack_.push(make_pair(root, (unsigned char)0));
-        increment();
-      } else
-        pt_ = 0;
+    iterator(map<key_type, mapped_type>* owner, pnode p)
+        : pt_(p), owner_(owner) {}
+
+    friend class map<key_type, mapped_type>;
+  };
+
+  class reverse_iterator {
+   public:
+    reverse_iterator() : pt_(0) {}
+
+    void operator++() { pt_ = predecessor(pt_); }
+
+    void operator++(int k) { pt_ = predecessor(pt_); }
+
+    pair<key_type, mapped_type>& operator*() {
+      assert(pt_);
+      return pt_->kv;
     }
 
-    iterator(map<key_type, mapped_type>* owner, pnode root, int is_end,
-             const key_type& k)
-        : owner_(owner) {
-      if (!owner || !root)
-        pt_ = 0;
-      else {
-        pnode p = root;
-        while (p) {
-          if (p->kv.first == k) {
-            traversal_stack_.push(make_pair(p, (unsigned char)2));
-            pt_ = p;
-            break;
-          } else if (k < p->kv.first) {
-            traversal_stack_.push(make_pair(p, (unsigned char)1));
-            p = p->left;
-          } else {
-            traversal_stack_.push(make_pair(p, (unsigned char)3));
-            p = p->right;
-          }
-        }
-        if (!p) {
-          traversal_stack_.clear();
-          pt_ = 0;
-        }
-      }
+    pair<key_type, mapped_type>* operator->() { return &(pt_->kv); }
+
+    int operator==(const reverse_iterator& rhs) const {
+      return pt_ == rhs.pt_;
     }
 
-    void increment() {
-      for (;;) {
-        if (traversal_stack_.empty()) {
-          pt_ = 0;
-          return;
-        }
-        pair<pnode, unsigned char>& curr = traversal_stack_.top();
-        switch (curr.second) {
-          case 0: {
-            curr.second++;
-            if (curr.first->left) {
-              traversal_stack_.push(
-                  make_pair(curr.first->left, (unsigned char)0));
-            }
-            break;
-          }
-          case 1: {
-            curr.second++;
-            pt_ = curr.first;
-            return;
-          }
-          case 2: {
-            curr.second++;
-            if (curr.first->right) {
-              traversal_stack_.push(
-                  make_pair(curr.first->right, (unsigned char)0));
-            }
-            break;
-          }
-          case 3: {
-            traversal_stack_.pop();
-          }
-        }
-      }
+    int operator!=(const reverse_iterator& rhs) const {
+      return pt_ != rhs.pt_;
     }
 
+   private:
+    typedef map<key_type, mapped_type>::node* pnode;
+
+    pnode pt_;
+
+    reverse_iterator(pnode p) : pt_(p) {}
+
     friend class map<key_type, mapped_type>;
   };
 
-  iterator begin() { return iterator(this, root_, 0); }
+  iterator begin() { return iterator(this, leftmost(root_)); }
+
+  iterator end() { return iterator(this, 0); }
+
+  reverse_iterator rbegin() { return reverse_iterator(rightmost(root_)); }
 
-  iterator end() { return iterator(this, root_, 1); }
+  reverse_iterator rend() { return reverse_iterator(0); }
 
-  iterator find(const key_type& key) { return iterator(this, root_, 0, key); }
+  iterator find(const key_type& key) {
+    return iterator(this, search(key));
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+
+  // Inserts key with a default value unless it is already there. Either way
+  // it takes a single descent; .second is nonzero if the key was inserted.
+  pair<iterator, int> try_emplace(const key_type& key) {
+    pnode parent;
+    int right;
+    pnode p = locate(key, parent, right);
+    if (p) return make_pair(iterator(this, p), 0);
+    return make_pair(iterator(this, attach(parent, right, new_node(key))), 1);
+  }
+
+  pair<iterator, int> try_emplace(const key_type& key, const mapped_type& val) {
+    pnode parent;
+    int right;
+    pnode p = locate(key, parent, right);
+    if (p) return make_pair(iterator(this, p), 0);
+    return make_pair(iterator(this, attach(parent, right, new_node(key, val))),
+                     1);
+  }
+
+  // Inserts key or overwrites its value; .second is nonzero if the key was
+  // inserted.
+  pair<iterator, int> insert(const key_type& key, const mapped_type& val) {
+    pair<iterator, int> res = try_emplace(key, val);
+    if (!res.second) res.first->second = val;
+    return res;
+  }
+
+  // Like insert(key, val), but if key belongs right before hint the descent is
+  // skipped. Inserting keys in ascending order at end() is amortized O(1).
+  iterator insert(iterator hint, const key_type& key, const mapped_type& val) {
+    pnode next = hint.pt_;
+    pnode prev = next ? predecessor(next) : rightmost_;
+    if ((prev && compare(prev->kv.first, key) >= 0) ||
+        (next && compare(key, next->kv.first) >= 0))
+      return insert(key, val).first;
+    // Either prev has no right child, or next is leftmost in prev's right
+    // subtree and has no left child.
+    if (prev && !prev->right)
+      return iterator(this, attach(prev, 1, new_node(key, val)));
+    return iterator(this, attach(next, 0, new_node(key, val)));
+  }
 };
 
 #endif  // _STL_MAP_H_
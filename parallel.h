@@ -0,0 +1,507 @@
+// File: parallel.h
+//
+// Description: Chunked parallel algorithms over random access ranges. Work
+//              is cut into chunks of grain elements, and an executor runs
+//              the chunks: serially by default, or on a thread pool where
+//              POSIX threads are available.
+
+#ifndef _STL_PARALLEL_H_
+#define _STL_PARALLEL_H_
+
+#include "algo.h"
+#include "utility.h"
+
+#ifdef _REENTRANT
+#include <pthread.h>
+#endif
+
+// A loop body cut into numbered chunks.
+class range_task {
+ public:
+  virtual void run(int chunk) = 0;
+};
+
+class executor {
+ public:
+  virtual ~executor() {}
+
+  // Calls task.run(i) for every i in [0, chunks), in any order and possibly
+  // concurrently, and returns once all calls have returned.
+  virtual void run(range_task& task, int chunks) = 0;
+};
+
+class serial_executor : public executor {
+ public:
+  void run(range_task& task, int chunks) {
+    for (int i = 0; i < chunks; i++) task.run(i);
+  }
+};
+
+inline executor& default_executor() {
+  static serial_executor ex;
+  return ex;
+}
+
+#ifdef _REENTRANT
+
+// Runs chunks on threads - 1 workers and on the thread calling run(), which
+// claim chunks one at a time so uneven chunks balance out. run() must not be
+// called from two threads at once or from inside a task.
+class thread_pool : public executor {
+ public:
+  thread_pool(int threads)
+      : workers_(0),
+        n_workers_(threads > 1 ? threads - 1 : 0),
+        task_(0),
+        chunks_(0),
+        next_(0),
+        pending_(0),
+        generation_(0),
+        stop_(0) {
+    pthread_mutex_init(&mu_, 0);
+    pthread_cond_init(&work_cv_, 0);
+    pthread_cond_init(&done_cv_, 0);
+    workers_ = new pthread_t[n_workers_ ? n_workers_ : 1];
+    // If the system runs out of threads, the pool makes do with those that
+    // started; threads() reports how many that is.
+    for (int i = 0; i < n_workers_; i++) {
+      if (pthread_create(&workers_[i], 0, worker_main, this)) {
+        n_workers_ = i;
+        break;
+      }
+    }
+  }
+
+  ~thread_pool() {
+    pthread_mutex_lock(&mu_);
+    stop_ = 1;
+    pthread_cond_broadcast(&work_cv_);
+    pthread_mutex_unlock(&mu_);
+    for (int i = 0; i < n_workers_; i++) pthread_join(workers_[i], 0);
+    delete[] workers_;
+    pthread_cond_destroy(&done_cv_);
+    pthread_cond_destroy(&work_cv_);
+    pthread_mutex_destroy(&mu_);
+  }
+
+  int threads() const { return n_workers_ + 1; }
+
+  void run(range_task& task, int chunks) {
+    if (chunks <= 0) return;
+    pthread_mutex_lock(&mu_);
+    task_ = &task;
+    chunks_ = chunks;
+    next_ = 0;
+    pending_ = chunks;
+    generation_++;
+    pthread_cond_broadcast(&work_cv_);
+    pthread_mutex_unlock(&mu_);
+
+    work();
+
+    pthread_mutex_lock(&mu_);
+    while (pending_) pthread_cond_wait(&done_cv_, &mu_);
+    task_ = 0;
+    pthread_mutex_unlock(&mu_);
+  }
+
+ private:
+  pthread_t* workers_;
+  int n_workers_;
+  pthread_mutex_t mu_;
+  pthread_cond_t work_cv_, done_cv_;
+  range_task* task_;
+  int chunks_, next_, pending_;
+  unsigned generation_;
+  int stop_;
+
+  thread_pool(const thread_pool&);
+  thread_pool& operator=(const thread_pool&);
+
+  // Claims and runs chunks of the current task until none are left.
+  void work() {
+    pthread_mutex_lock(&mu_);
+    while (task_ && next_ < chunks_) {
+      range_task* task = task_;
+      int chunk = next_++;
+      pthread_mutex_unlock(&mu_);
+      task->run(chunk);
+      pthread_mutex_lock(&mu_);
+      if (!--pending_) pthread_cond_signal(&done_cv_);
+    }
+    pthread_mutex_unlock(&mu_);
+  }
+
+  static void* worker_main(void* arg) {
+    thread_pool* pool = (thread_pool*)arg;
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool->mu_);
+    for (;;) {
+      while (!pool->stop_ && pool->generation_ == seen)
+        pthread_cond_wait(&pool->work_cv_, &pool->mu_);
+      if (pool->stop_) break;
+      seen = pool->generation_;
+      pthread_mutex_unlock(&pool->mu_);
+      pool->work();
+      pthread_mutex_lock(&pool->mu_);
+    }
+    pthread_mutex_unlock(&pool->mu_);
+    return 0;
+  }
+};
+
+#endif  // _REENTRANT
+
+////////////////////////////////////////////////////////////////////////////////
+//  Chunk tasks:
+////////////////////////////////////////////////////////////////////////////////
+
+// The algorithms below wrap their loops in these tasks. Class templates,
+// unlike function templates, aren't found by argument lookup, so they come
+// first.
+
+inline int _chunk_count(int n, int grain) {
+  if (grain < 1) grain = 1;
+  return n > 0 ? (n - 1) / grain + 1 : 0;
+}
+
+// The base of the tasks below: chunk i covers [begin(i), end(i)) of n.
+class _chunked_task : public range_task {
+ public:
+  _chunked_task(int n, int grain) : n_(n), grain_(grain < 1 ? 1 : grain) {}
+
+ protected:
+  int n_, grain_;
+
+  int begin(int chunk) const { return chunk * grain_; }
+  int end(int chunk) const { return min(n_, (chunk + 1) * grain_); }
+};
+
+template <class RandomAccessIterator, class Function>
+class _for_each_task : public _chunked_task {
+ public:
+  _for_each_task(RandomAccessIterator first, int n, int grain, Function fn)
+      : _chunked_task(n, grain), first_(first), fn_(fn) {}
+
+  void run(int chunk) {
+    Function fn = fn_;
+    for (int i = begin(chunk), e = end(chunk); i < e; i++) fn(first_[i]);
+  }
+
+ private:
+  RandomAccessIterator first_;
+  Function fn_;
+};
+
+template <class RandomAccessIterator, class OutputIterator, class Function>
+class _transform_task : public _chunked_task {
+ public:
+  _transform_task(RandomAccessIterator first, int n, int grain,
+                  OutputIterator out, Function fn)
+      : _chunked_task(n, grain), first_(first), out_(out), fn_(fn) {}
+
+  void run(int chunk) {
+    Function fn = fn_;
+    for (int i = begin(chunk), e = end(chunk); i < e; i++)
+      out_[i] = fn(first_[i]);
+  }
+
+ private:
+  RandomAccessIterator first_;
+  OutputIterator out_;
+  Function fn_;
+};
+
+// Constructs the result of chunk i in the raw slot partial[i].
+template <class RandomAccessIterator, class T, class BinaryOperation>
+class _reduce_task : public _chunked_task {
+ public:
+  _reduce_task(RandomAccessIterator first, int n, int grain, T* partial,
+               BinaryOperation op)
+      : _chunked_task(n, grain), first_(first), partial_(partial), op_(op) {}
+
+  void run(int chunk) {
+    BinaryOperation op = op_;
+    int i = begin(chunk), e = end(chunk);
+    T acc = first_[i];
+    for (i++; i < e; i++) acc = op(acc, first_[i]);
+    _construct(partial_ + chunk, acc);
+  }
+
+ private:
+  RandomAccessIterator first_;
+  T* partial_;
+  BinaryOperation op_;
+};
+
+template <class RandomAccessIterator, class Compare>
+class _sort_task : public _chunked_task {
+ public:
+  _sort_task(RandomAccessIterator first, int n, int grain, Compare comp)
+      : _chunked_task(n, grain), first_(first), comp_(comp) {}
+
+  void run(int chunk) {
+    sort(first_ + begin(chunk), first_ + end(chunk), comp_);
+  }
+
+ private:
+  RandomAccessIterator first_;
+  Compare comp_;
+};
+
+// Merges the sorted runs of width elements of src pairwise into dst. Chunk i
+// writes dst[begin(i), end(i)), finding where its inputs start by binary
+// search, so chunks never wait for each other.
+template <class Source, class Dest, class Compare>
+class _merge_task : public _chunked_task {
+ public:
+  _merge_task(Source src, Dest dst, int n, int width, int grain, Compare comp)
+      : _chunked_task(n, grain),
+        src_(src),
+        dst_(dst),
+        width_(width),
+        comp_(comp) {}
+
+  void run(int chunk) {
+    int out = begin(chunk), e = end(chunk);
+    int lo = out - out % (2 * width_);
+    int mid = min(lo + width_, n_), hi = min(lo + 2 * width_, n_);
+    int la = mid - lo, lb = hi - mid;
+    // i elements of the left run and d - i of the right one precede out.
+    int d = out - lo;
+    int a = d > lb ? d - lb : 0, b = min(d, la);
+    while (a < b) {
+      int i = (a + b) / 2;
+      if (!comp_(src_[mid + d - i - 1], src_[lo + i]))
+        a = i + 1;
+      else
+        b = i;
+    }
+    int i = lo + a, j = mid + d - a;
+    while (out < e) {
+      if (j == hi || (i < mid && !comp_(src_[j], src_[i])))
+        dst_[out++] = src_[i++];
+      else
+        dst_[out++] = src_[j++];
+    }
+  }
+
+ private:
+  Source src_;
+  Dest dst_;
+  int width_;
+  Compare comp_;
+};
+
+template <class Source, class Dest>
+class _copy_task : public _chunked_task {
+ public:
+  _copy_task(Source src, Dest dst, int n, int grain)
+      : _chunked_task(n, grain), src_(src), dst_(dst) {}
+
+  void run(int chunk) {
+    for (int i = begin(chunk), e = end(chunk); i < e; i++) dst_[i] = src_[i];
+  }
+
+ private:
+  Source src_;
+  Dest dst_;
+};
+
+// Copy-constructs src[i] into the raw slot dst + i.
+template <class Source, class T>
+class _construct_task : public _chunked_task {
+ public:
+  _construct_task(Source src, T* dst, int n, int grain)
+      : _chunked_task(n, grain), src_(src), dst_(dst) {}
+
+  void run(int chunk) {
+    for (int i = begin(chunk), e = end(chunk); i < e; i++)
+      _construct(dst_ + i, src_[i]);
+  }
+
+ private:
+  Source src_;
+  T* dst_;
+};
+
+template <class T>
+class _destroy_task : public _chunked_task {
+ public:
+  _destroy_task(T* buf, int n, int grain)
+      : _chunked_task(n, grain), buf_(buf) {}
+
+  void run(int chunk) {
+    for (int i = begin(chunk), e = end(chunk); i < e; i++) _destroy(buf_ + i);
+  }
+
+ private:
+  T* buf_;
+};
+
+template <class RandomAccessIterator, class Compare, class T>
+void _parallel_sort(executor& ex, RandomAccessIterator first, int n,
+                    int grain, Compare comp, T*) {
+  // As in _chunk_count; the merges double the run width from grain, so it
+  // must not be 0.
+  if (grain < 1) grain = 1;
+  int chunks = _chunk_count(n, grain);
+  _sort_task<RandomAccessIterator, Compare> sorter(first, n, grain, comp);
+  ex.run(sorter, chunks);
+
+  // Filling and emptying the buffer touch all of it, like a merge level, so
+  // they are spread over the executor too.
+  T* buf = _allocate(n, (T*)0);
+  _construct_task<RandomAccessIterator, T> fill(first, buf, n, grain);
+  ex.run(fill, chunks);
+  int in_buf = 0;
+  for (int width = grain; width < n; width *= 2) {
+    if (in_buf) {
+      _merge_task<T*, RandomAccessIterator, Compare> merge(buf, first, n,
+                                                           width, grain, comp);
+      ex.run(merge, chunks);
+    } else {
+      _merge_task<RandomAccessIterator, T*, Compare> merge(first, buf, n,
+                                                           width, grain, comp);
+      ex.run(merge, chunks);
+    }
+    in_buf = !in_buf;
+  }
+  if (in_buf) {
+    _copy_task<T*, RandomAccessIterator> copy(buf, first, n, grain);
+    ex.run(copy, chunks);
+  }
+  if (!is_trivially_copyable(buf)) {
+    _destroy_task<T> empty(buf, n, grain);
+    ex.run(empty, chunks);
+  }
+  _deallocate(buf);
+}
+
+// Sifts down the nodes [lo, hi) of one level.
+template <class RandomAccessIterator, class Compare>
+class _heapify_task : public _chunked_task {
+ public:
+  _heapify_task(RandomAccessIterator first, int n, int lo, int hi, int grain,
+                Compare comp)
+      : _chunked_task(hi - lo, grain),
+        first_(first),
+        size_(n),
+        lo_(lo),
+        comp_(comp) {}
+
+  void run(int chunk) {
+    for (int i = begin(chunk), e = end(chunk); i < e; i++)
+      _heap_hole_down(first_, size_, lo_ + i, first_[lo_ + i], comp_);
+  }
+
+ private:
+  RandomAccessIterator first_;
+  int size_, lo_;
+  Compare comp_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Parallel algorithms:
+////////////////////////////////////////////////////////////////////////////////
+
+// Each algorithm cuts [first, last) into chunks of grain elements (the last
+// one may be shorter) and hands them to ex. Chunk boundaries depend only on
+// the range and grain, never on the executor, so results are the same
+// whichever executor runs them.
+
+template <class RandomAccessIterator, class Function>
+void parallel_for_each(executor& ex, RandomAccessIterator first,
+                       RandomAccessIterator last, Function fn,
+                       int grain = 1024) {
+  _for_each_task<RandomAccessIterator, Function> task(first, last - first,
+                                                      grain, fn);
+  ex.run(task, _chunk_count(last - first, grain));
+}
+
+// out[i] = fn(first[i]); out must have room for the whole range.
+template <class RandomAccessIterator, class OutputIterator, class Function>
+void parallel_transform(executor& ex, RandomAccessIterator first,
+                        RandomAccessIterator last, OutputIterator out,
+                        Function fn, int grain = 1024) {
+  _transform_task<RandomAccessIterator, OutputIterator, Function> task(
+      first, last - first, grain, out, fn);
+  ex.run(task, _chunk_count(last - first, grain));
+}
+
+// Folds each chunk from its first element on with op, then folds init and
+// the chunk results in chunk order. op must be associative; the grouping is
+// fixed by grain, so floating point sums come out bit for bit the same on
+// any executor.
+template <class RandomAccessIterator, class T, class BinaryOperation>
+T parallel_reduce(executor& ex, RandomAccessIterator first,
+                  RandomAccessIterator last, T init, BinaryOperation op,
+                  int grain = 1024) {
+  int n = last - first;
+  int chunks = _chunk_count(n, grain);
+  if (!chunks) return init;
+  T* partial = _allocate(chunks, (T*)0);
+  _reduce_task<RandomAccessIterator, T, BinaryOperation> task(first, n, grain,
+                                                              partial, op);
+  ex.run(task, chunks);
+  for (int i = 0; i < chunks; i++) {
+    init = op(init, partial[i]);
+    _destroy(partial + i);
+  }
+  _deallocate(partial);
+  return init;
+}
+
+// Sorts the chunks, then merges runs of doubling length through a buffer of
+// the whole range. Each merge is split by output position, so every level
+// has as many tasks as there are chunks. Not stable.
+template <class RandomAccessIterator>
+void parallel_sort(executor& ex, RandomAccessIterator first,
+                   RandomAccessIterator last, int grain = 16384) {
+  if (last - first > 1)
+    parallel_sort(ex, first, last, _less_for(&*first), grain);
+}
+
+template <class RandomAccessIterator, class Compare>
+void parallel_sort(executor& ex, RandomAccessIterator first,
+                   RandomAccessIterator last, Compare comp,
+                   int grain = 16384) {
+  int n = last - first;
+  if (n <= grain) {
+    sort(first, last, comp);
+    return;
+  }
+  _parallel_sort(ex, first, n, grain, comp, &*first);
+}
+
+// Builds the heap of make_heap level by level from the bottom: the subtrees
+// sifted on one level are disjoint, so each level runs in parallel. grain
+// counts nodes of a level.
+template <class RandomAccessIterator>
+void parallel_make_heap(executor& ex, RandomAccessIterator first,
+                        RandomAccessIterator last, int grain = 4096) {
+  if (last - first > 1)
+    parallel_make_heap(ex, first, last, _less_for(&*first), grain);
+}
+
+template <class RandomAccessIterator, class Compare>
+void parallel_make_heap(executor& ex, RandomAccessIterator first,
+                        RandomAccessIterator last, Compare comp,
+                        int grain = 4096) {
+  int n = last - first;
+  if (n < 2) return;
+  // The nodes at depth d are [level - 1, 2 * level - 1) for level = 2^d, and
+  // the last one with children is (n - 2) / 2.
+  int level = 1;
+  while (2 * level - 1 <= (n - 2) / 2) level *= 2;
+  for (; level; level /= 2) {
+    int lo = level - 1;
+    int hi = min(2 * level - 1, n / 2);
+    if (lo >= hi) continue;
+    _heapify_task<RandomAccessIterator, Compare> task(first, n, lo, hi, grain,
+                                                      comp);
+    ex.run(task, _chunk_count(hi - lo, grain));
+  }
+}
+
+#endif  // _STL_PARALLEL_H_
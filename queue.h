@@ -5,20 +5,30 @@
 #ifndef _STL_QUEUE_H_
 #define _STL_QUEUE_H_
 
+#include "deque.h"
 #include "list.h"
+#include "vector.h"
+
+#include <assert.h>
 
 // It seems that BCC doesn't support this:
-// template<class T, class Container = list<T> >
+// template<class T, class Container = deque<T> >
+//
+// Backed by a ring buffer: push and pop don't allocate once the buffer has
+// grown to the queue's peak depth.
 template <class T>
 class queue {
  public:
-  typedef list<T> Container;
+  typedef deque<T> Container;
   typedef T value_type;
   typedef Container::size_type size_type;
   typedef Container::iterator iterator;
 
   queue() : container_() {}
 
+  // Allocates through alloc, see allocator.h.
+  queue(allocator& alloc) : container_(alloc) {}
+
   queue(const queue& cp) : container_(cp.container_) {}
 
   int empty() const { return container_.empty(); }
@@ -29,6 +39,10 @@ class queue {
 
   const value_type& front() const { return container_.front(); }
 
+  value_type& back() { return container_.back(); }
+
+  const value_type& back() const { return container_.back(); }
+
   void push(const value_type& val) { container_.push_back(val); }
 
   void pop() { container_.pop_front(); }
@@ -49,4 +63,222 @@ class queue {
   Container container_;
 };
 
+// A min-heap in a vector where each node has D children: top() is the
+// smallest element. Compared to the binary heap of push_heap/pop_heap, a
+// 4-ary or 8-ary heap is half or a third as deep and looks at siblings that
+// share a cache line, at the price of more comparisons per level on pop.
+// D must be at least 2.
+template <class T, unsigned D>
+class d_ary_priority_queue {
+ public:
+  typedef T value_type;
+  typedef unsigned size_type;
+
+  d_ary_priority_queue() : heap_() {}
+
+  // Heapifies items bottom-up in O(n).
+  d_ary_priority_queue(const vector<value_type>& items) : heap_(items) {
+    for (size_type i = heap_.size() / D + 1; i-- > 0;)
+      if (D * i + 1 < heap_.size()) sift_down(i, heap_[i]);
+  }
+
+  int empty() const { return heap_.empty(); }
+
+  size_type size() const { return heap_.size(); }
+
+  const value_type& top() const { return heap_.front(); }
+
+  void push(const value_type& val) {
+    // val may be an element, which push_back can move.
+    heap_.push_back(val);
+    sift_up(heap_.size() - 1, heap_.back());
+  }
+
+  void pop() {
+    assert(!heap_.empty());
+    value_type last = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) sift_down(0, last);
+  }
+
+  void reserve(size_type cap) { heap_.reserve(cap); }
+
+  void clear() { heap_.clear(); }
+
+ private:
+  vector<value_type> heap_;
+
+  // Both sifts move a hole from idx and write val once where it settles.
+  void sift_up(size_type idx, value_type val) {
+    while (idx) {
+      size_type parent = (idx - 1) / D;
+      if (!(val < heap_[parent])) break;
+      heap_[idx] = heap_[parent];
+      idx = parent;
+    }
+    heap_[idx] = val;
+  }
+
+  void sift_down(size_type idx, value_type val) {
+    size_type n = heap_.size();
+    for (;;) {
+      size_type child = D * idx + 1;
+      if (child >= n) break;
+      size_type last = n - child > D ? child + D : n;
+      size_type best = child;
+      for (size_type i = child + 1; i < last; i++)
+        if (heap_[i] < heap_[best]) best = i;
+      if (!(heap_[best] < val)) break;
+      heap_[idx] = heap_[best];
+      idx = best;
+    }
+    heap_[idx] = val;
+  }
+};
+
+// The binary min-heap. BCC has no default template arguments, so the arity
+// is fixed by name, as with stack and small_stack.
+template <class T>
+class priority_queue : public d_ary_priority_queue<T, 2> {
+ public:
+  priority_queue() {}
+
+  priority_queue(const vector<T>& items) : d_ary_priority_queue<T, 2>(items) {}
+};
+
+// A D-ary min-heap whose elements can be found again: push() returns a handle
+// that stays valid until the element is popped or erased, and that lets the
+// element be reprioritized or removed in O(log n). Handles of removed
+// elements are reused.
+template <class T, unsigned D>
+class indexed_priority_queue {
+ public:
+  typedef T value_type;
+  typedef unsigned size_type;
+  typedef unsigned handle;
+
+  indexed_priority_queue() : heap_(), pos_(), free_() {}
+
+  int empty() const { return heap_.empty(); }
+
+  size_type size() const { return heap_.size(); }
+
+  const value_type& top() const { return heap_.front().val; }
+
+  handle top_handle() const { return heap_.front().h; }
+
+  // Nonzero while h refers to a queued element.
+  int contains(handle h) const { return h < pos_.size() && pos_[h]; }
+
+  const value_type& operator[](handle h) const {
+    assert(contains(h));
+    return heap_[pos_[h] - 1].val;
+  }
+
+  handle push(const value_type& val) {
+    handle h;
+    if (free_.empty()) {
+      h = pos_.size();
+      pos_.push_back(0);
+    } else {
+      h = free_.back();
+      free_.pop_back();
+    }
+    entry e(val, h);
+    heap_.push_back(e);
+    sift_up(heap_.size() - 1, e);
+    return h;
+  }
+
+  void pop() { erase(top_handle()); }
+
+  // val must not order after the current value of h.
+  void decrease_key(handle h, const value_type& val) {
+    assert(contains(h));
+    assert(!(heap_[pos_[h] - 1].val < val));
+    sift_up(pos_[h] - 1, entry(val, h));
+  }
+
+  // Gives h the new value val, whichever way it moves.
+  void update(handle h, const value_type& val) {
+    assert(contains(h));
+    size_type idx = pos_[h] - 1;
+    if (val < heap_[idx].val)
+      sift_up(idx, entry(val, h));
+    else
+      sift_down(idx, entry(val, h));
+  }
+
+  void erase(handle h) {
+    assert(contains(h));
+    size_type idx = pos_[h] - 1;
+    pos_[h] = 0;
+    free_.push_back(h);
+    entry last = heap_.back();
+    heap_.pop_back();
+    if (idx == heap_.size()) return;
+    // The last element fills the hole and may have to move either way.
+    if (idx && last.val < heap_[(idx - 1) / D].val)
+      sift_up(idx, last);
+    else
+      sift_down(idx, last);
+  }
+
+  void reserve(size_type cap) {
+    heap_.reserve(cap);
+    pos_.reserve(cap);
+  }
+
+  // Invalidates all handles.
+  void clear() {
+    heap_.clear();
+    pos_.clear();
+    free_.clear();
+  }
+
+ private:
+  struct entry {
+    value_type val;
+    handle h;
+    entry(const value_type& val, handle h) : val(val), h(h) {}
+  };
+
+  vector<entry> heap_;
+  // One past the heap index of each handle, 0 for handles not in use.
+  vector<size_type> pos_;
+  vector<handle> free_;
+
+  // Like the sifts of d_ary_priority_queue, also keeping pos_ up to date.
+  void sift_up(size_type idx, entry e) {
+    while (idx) {
+      size_type parent = (idx - 1) / D;
+      if (!(e.val < heap_[parent].val)) break;
+      place(idx, heap_[parent]);
+      idx = parent;
+    }
+    place(idx, e);
+  }
+
+  void sift_down(size_type idx, entry e) {
+    size_type n = heap_.size();
+    for (;;) {
+      size_type child = D * idx + 1;
+      if (child >= n) break;
+      size_type last = n - child > D ? child + D : n;
+      size_type best = child;
+      for (size_type i = child + 1; i < last; i++)
+        if (heap_[i].val < heap_[best].val) best = i;
+      if (!(heap_[best].val < e.val)) break;
+      place(idx, heap_[best]);
+      idx = best;
+    }
+    place(idx, e);
+  }
+
+  void place(size_type idx, const entry& e) {
+    heap_[idx] = e;
+    pos_[e.h] = idx + 1;
+  }
+};
+
 #endif  // _STL_QUEUE_H_
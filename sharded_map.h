@@ -0,0 +1,215 @@
+// File: sharded_map.h
+//
+// Description: Concurrent map that hash-partitions its keys over independently
+//              locked shards, each an ordinary map behind a reader-writer
+//              lock. Operations on different shards never wait for each
+//              other, and lookups don't block each other at all. Not for
+//              builds with STL_INSTRUMENT, whose counters are written by
+//              lookups under the shared lock (see instrument.h).
+
+#ifndef _STL_SHARDED_MAP_H_
+#define _STL_SHARDED_MAP_H_
+
+#include "atomic.h"
+#include "hash.h"
+#include "map.h"
+
+#include <assert.h>
+
+// A reader-writer spinlock for short critical sections. state_ counts the
+// readers inside, or is -1 while a writer is. Waiting writers hold new
+// readers back, so a steady stream of lookups can't starve them.
+class rw_spinlock {
+ public:
+  rw_spinlock() : state_(0), writers_waiting_(0) {}
+
+  void lock_shared() {
+    for (;;) {
+      while (atomic_load_relaxed(&writers_waiting_)) cpu_relax();
+      long s = atomic_load_relaxed(&state_);
+      if (s >= 0 && atomic_compare_exchange(&state_, s, s + 1)) return;
+      cpu_relax();
+    }
+  }
+
+  void unlock_shared() { atomic_fetch_add(&state_, -1L); }
+
+  void lock() {
+    atomic_fetch_add(&writers_waiting_, 1L);
+    long s = 0;
+    while (!atomic_compare_exchange(&state_, s, -1L)) {
+      s = 0;
+      cpu_relax();
+    }
+    atomic_fetch_add(&writers_waiting_, -1L);
+  }
+
+  void unlock() { atomic_store_release(&state_, 0L); }
+
+ private:
+  volatile long state_;
+  volatile long writers_waiting_;
+
+  rw_spinlock(const rw_spinlock&);
+  rw_spinlock& operator=(const rw_spinlock&);
+};
+
+// Keys need a hash_value overload (see hash.h) besides what map needs. Values
+// are copied out rather than referenced, as a reference would outlive the
+// lock. update() and for_each() below are free functions, since BCC has no
+// member templates.
+template <class Key, class Value>
+class sharded_map {
+ public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef unsigned size_type;
+
+  // shards is rounded up to a power of two. A few times the number of
+  // threads keeps collisions between writers rare.
+  sharded_map(size_type shards) : shards_(0), count_(1), bits_(0) {
+    while (count_ < shards) {
+      count_ *= 2;
+      bits_++;
+    }
+    shards_ = new shard[count_];
+  }
+
+  ~sharded_map() { delete[] shards_; }
+
+  // Direct access to the partitions, for the free functions below: hold
+  // shard_lock(i) for reading to read shard_items(i) and for writing to
+  // change it.
+  size_type shard_count() const { return count_; }
+
+  size_type shard_index(const key_type& key) const {
+    return bits_ ? _hash_index(hash_value(key), bits_) : 0;
+  }
+
+  rw_spinlock& shard_lock(size_type idx) {
+    assert(idx < count_);
+    return shards_[idx].lock;
+  }
+
+  map<Key, Value>& shard_items(size_type idx) {
+    assert(idx < count_);
+    return shards_[idx].items;
+  }
+
+  // Copies the value of key into val; returns 0 if key is absent.
+  int find(const key_type& key, mapped_type& val) {
+    shard& s = shards_[shard_index(key)];
+    s.lock.lock_shared();
+    items_iterator it = s.items.find(key);
+    int found = it != s.items.end();
+    if (found) val = it->second;
+    s.lock.unlock_shared();
+    return found;
+  }
+
+  int contains(const key_type& key) {
+    shard& s = shards_[shard_index(key)];
+    s.lock.lock_shared();
+    int found = s.items.find(key) != s.items.end();
+    s.lock.unlock_shared();
+    return found;
+  }
+
+  // Inserts key or overwrites its value; returns nonzero if it was inserted.
+  int insert(const key_type& key, const mapped_type& val) {
+    shard& s = shards_[shard_index(key)];
+    s.lock.lock();
+    int inserted = s.items.insert(key, val).second;
+    s.lock.unlock();
+    return inserted;
+  }
+
+  // Returns nonzero if key was there.
+  int erase(const key_type& key) {
+    shard& s = shards_[shard_index(key)];
+    s.lock.lock();
+    size_type before = s.items.size();
+    s.items.erase(key);
+    int erased = s.items.size() != before;
+    s.lock.unlock();
+    return erased;
+  }
+
+  // The sum of the shard sizes, each read under its lock. Not a snapshot of
+  // the whole map while writers are busy.
+  size_type size() {
+    size_type n = 0;
+    for (size_type i = 0; i < count_; i++) {
+      shards_[i].lock.lock_shared();
+      n += shards_[i].items.size();
+      shards_[i].lock.unlock_shared();
+    }
+    return n;
+  }
+
+  void clear() {
+    for (size_type i = 0; i < count_; i++) {
+      shards_[i].lock.lock();
+      shards_[i].items.clear();
+      shards_[i].lock.unlock();
+    }
+  }
+
+ private:
+  enum { kCacheLine = 64 };
+
+  // Every lookup writes its shard's lock, so neighbouring shards must not
+  // share a cache line. new[] can't promise more than word alignment, so
+  // each shard is followed by a whole line of padding rather than rounded
+  // up to a multiple of one.
+  struct shard {
+    rw_spinlock lock;
+    map<Key, Value> items;
+    char pad[kCacheLine];
+  };
+  typedef map<Key, Value>::iterator items_iterator;
+
+  shard* shards_;
+  size_type count_;
+  unsigned bits_;
+
+  sharded_map(const sharded_map&);
+  sharded_map& operator=(const sharded_map&);
+};
+
+template <class Iterator, class Function>
+void _for_each_in(Iterator first, Iterator last, Function fn) {
+  for (; first != last; ++first) fn(*first);
+}
+
+// Calls fn(value) on the value of key under its shard's write lock, first
+// inserting a default-constructed value if key is absent, so read-modify-write
+// steps such as counters are atomic. Returns nonzero if key was inserted.
+template <class Key, class Value, class Function>
+int update(sharded_map<Key, Value>& m, const Key& key, Function fn) {
+  unsigned idx = m.shard_index(key);
+  m.shard_lock(idx).lock();
+  map<Key, Value>& items = m.shard_items(idx);
+  unsigned before = items.size();
+  Value& val = items[key];
+  int inserted = items.size() != before;
+  fn(val);
+  m.shard_lock(idx).unlock();
+  return inserted;
+}
+
+// Calls fn(pair) on every element in key order within each shard. Each shard
+// is visited under its read lock, so it is seen consistently, though writers
+// may change other shards in between. fn must neither change the elements
+// nor call back into m.
+template <class Key, class Value, class Function>
+void for_each(sharded_map<Key, Value>& m, Function fn) {
+  for (unsigned i = 0; i < m.shard_count(); i++) {
+    m.shard_lock(i).lock_shared();
+    map<Key, Value>& items = m.shard_items(i);
+    _for_each_in(items.begin(), items.end(), fn);
+    m.shard_lock(i).unlock_shared();
+  }
+}
+
+#endif  // _STL_SHARDED_MAP_H_
@@ -0,0 +1,67 @@
+// File: small_vector.h
+//
+// Description: vector that keeps up to N elements in an inline buffer and only
+//              allocates once it grows past N. It is a vector<T>, so it can be
+//              passed as one and its iterators are vector<T>::iterator.
+
+#ifndef _STL_SMALL_VECTOR_H_
+#define _STL_SMALL_VECTOR_H_
+
+#include "vector.h"
+
+template <class T, unsigned N>
+class small_vector : public vector<T> {
+ public:
+  small_vector() : vector<T>(buffer(), N) {}
+
+  small_vector(unsigned size) : vector<T>(buffer(), N) {
+    vector<T>::resize(size);
+  }
+
+  small_vector(unsigned size, const T& val) : vector<T>(buffer(), N) {
+    vector<T>::resize(size, val);
+  }
+
+  small_vector(const small_vector& cp) : vector<T>(buffer(), N) {
+    vector<T>::operator=(cp);
+  }
+
+  small_vector(const vector<T>& cp) : vector<T>(buffer(), N) {
+    vector<T>::operator=(cp);
+  }
+
+  small_vector& operator=(const small_vector& cp) {
+    vector<T>::operator=(cp);
+    return *this;
+  }
+
+  small_vector& operator=(const vector<T>& cp) {
+    vector<T>::operator=(cp);
+    return *this;
+  }
+
+  // Moves back into the inline buffer once N elements or fewer are left, and
+  // otherwise shrinks the heap buffer. Called through a vector<T>& it is
+  // vector's, which never leaves the heap.
+  void shrink_to_fit() {
+    if (vector<T>::size() <= N)
+      vector<T>::return_inline(N);
+    else
+      vector<T>::shrink_to_fit();
+  }
+
+ private:
+  // Raw storage: elements are constructed in it by vector<T> as needed. The
+  // other members only force an alignment that suits any element type.
+  union storage {
+    char bytes[N * sizeof(T)];
+    long double align_float;
+    long align_int;
+    void* align_ptr;
+  };
+  storage buf_;
+
+  T* buffer() { return (T*)buf_.bytes; }
+};
+
+#endif  // _STL_SMALL_VECTOR_H_
@@ -0,0 +1,126 @@
+// File: spsc_ring.h
+//
+// Description: Bounded lock-free queue for exactly one producer and one
+//              consumer, such as an interrupt handler feeding a thread. The
+//              N slots live inside the object, so neither side ever
+//              allocates, locks or masks interrupts.
+
+#ifndef _STL_SPSC_RING_H_
+#define _STL_SPSC_RING_H_
+
+#include "atomic.h"
+#include "utility.h"
+
+#include <assert.h>
+
+// N must be a power of two. push() may only be called from the producer and
+// pop() only from the consumer; size() and empty() may be called from either
+// and are exact only on the consumer side.
+template <class T, unsigned N>
+class spsc_ring {
+ public:
+  typedef T value_type;
+  typedef unsigned size_type;
+
+  spsc_ring() : head_(0), cached_tail_(0), tail_(0), cached_head_(0) {
+    assert(N && !(N & (N - 1)));
+  }
+
+  ~spsc_ring() {
+    for (size_type i = head_; i != tail_; i++) _destroy(slot(i));
+  }
+
+  size_type capacity() const { return N; }
+
+  size_type size() const {
+    return atomic_load_acquire(&tail_) - atomic_load_acquire(&head_);
+  }
+
+  int empty() const { return !size(); }
+
+  // Producer side. Returns 0 without queueing val if the ring is full.
+  int push(const value_type& val) {
+    size_type tail = atomic_load_relaxed(&tail_);
+    if (tail - cached_head_ == N) {
+      cached_head_ = atomic_load_acquire(&head_);
+      if (tail - cached_head_ == N) return 0;
+    }
+    _construct(slot(tail), val);
+    atomic_store_release(&tail_, tail + 1);
+    return 1;
+  }
+
+  // Queues as many of the n items as fit, publishing them all at once, and
+  // returns how many that was.
+  size_type push(const value_type* items, size_type n) {
+    size_type tail = atomic_load_relaxed(&tail_);
+    if (N - (tail - cached_head_) < n)
+      cached_head_ = atomic_load_acquire(&head_);
+    size_type room = N - (tail - cached_head_);
+    if (n > room) n = room;
+    for (size_type i = 0; i < n; i++) _construct(slot(tail + i), items[i]);
+    if (n) atomic_store_release(&tail_, tail + n);
+    return n;
+  }
+
+  // Consumer side. Returns 0 and leaves val alone if the ring is empty.
+  int pop(value_type& val) {
+    size_type head = atomic_load_relaxed(&head_);
+    if (head == cached_tail_) {
+      cached_tail_ = atomic_load_acquire(&tail_);
+      if (head == cached_tail_) return 0;
+    }
+    value_type* p = slot(head);
+    val = *p;
+    _destroy(p);
+    atomic_store_release(&head_, head + 1);
+    return 1;
+  }
+
+  // Takes up to n items into out, releasing their slots at once, and returns
+  // how many that was.
+  size_type pop(value_type* out, size_type n) {
+    size_type head = atomic_load_relaxed(&head_);
+    if (cached_tail_ - head < n) cached_tail_ = atomic_load_acquire(&tail_);
+    size_type avail = cached_tail_ - head;
+    if (n > avail) n = avail;
+    for (size_type i = 0; i < n; i++) {
+      value_type* p = slot(head + i);
+      out[i] = *p;
+      _destroy(p);
+    }
+    if (n) atomic_store_release(&head_, head + n);
+    return n;
+  }
+
+ private:
+  enum { kCacheLine = 64 };
+
+  // head_ and tail_ count pops and pushes and wrap around freely; slot i is
+  // i % N. Each side also keeps its last sight of the other's index, so it
+  // only touches the other side's cache line when the ring looks full or
+  // empty. The padding keeps the two sides on separate cache lines.
+  volatile size_type head_;
+  size_type cached_tail_;
+  char pad_consumer_[kCacheLine];
+  volatile size_type tail_;
+  size_type cached_head_;
+  char pad_producer_[kCacheLine];
+
+  union storage {
+    char bytes[N * sizeof(T)];
+    long double align_float;
+    long align_int;
+    void* align_ptr;
+  };
+  storage buf_;
+
+  value_type* slot(size_type i) {
+    return (value_type*)buf_.bytes + (i & (N - 1));
+  }
+
+  spsc_ring(const spsc_ring&);
+  spsc_ring& operator=(const spsc_ring&);
+};
+
+#endif  // _STL_SPSC_RING_H_
@@ -6,20 +6,30 @@
 #define _STL_STACK_H_
 
 #include "list.h"
+#include "small_vector.h"
+#include "vector.h"
 
 // It seems that BCC doesn't support this:
-// template<class T, class Container = list<T> >
-template <class T>
-class stack {
+// template<class T, class Container = vector<T> >
+// so the adapter takes the container explicitly and stack and small_stack
+// below name it.
+//
+// The elements are contiguous with the top at the back: push and pop are
+// amortized O(1) and don't allocate per element. Iteration runs from the
+// bottom to the top.
+template <class T, class Container>
+class _stack_adapter {
  public:
-  typedef list<T> Container;
   typedef T value_type;
   typedef Container::size_type size_type;
   typedef Container::iterator iterator;
 
-  stack() : container_() {}
+  _stack_adapter() : container_() {}
+
+  // Only for containers that take an allocator, see allocator.h.
+  _stack_adapter(allocator& alloc) : container_(alloc) {}
 
-  stack(const stack& cp) : container_(cp.container_) {}
+  _stack_adapter(const _stack_adapter& cp) : container_(cp.container_) {}
 
   int empty() const { return container_.empty(); }
 
@@ -27,19 +37,19 @@ class stack {
 
   void clear() { container_.clear(); }
 
-  value_type& top() { return container_.front(); };
+  value_type& top() { return container_.back(); };
 
-  const value_type& top() const { return container_.front(); }
+  const value_type& top() const { return container_.back(); }
 
-  void push(const value_type& val) { container_.push_front(val); }
+  void push(const value_type& val) { container_.push_back(val); }
 
-  void pop() { container_.pop_front(); }
+  void pop() { container_.pop_back(); }
 
-  int operator==(const stack& rhs) const {
+  int operator==(const _stack_adapter& rhs) const {
     return container_ == rhs.container_;
   }
 
-  int operator!=(const stack& rhs) const {
+  int operator!=(const _stack_adapter& rhs) const {
     return container_ != rhs.container_;
   }
 
@@ -51,4 +61,17 @@ class stack {
   Container container_;
 };
 
+template <class T>
+class stack : public _stack_adapter<T, vector<T> > {
+ public:
+  stack() {}
+
+  // Allocates through alloc, see allocator.h.
+  stack(allocator& alloc) : _stack_adapter<T, vector<T> >(alloc) {}
+};
+
+// Keeps up to N elements inline, for stacks that are usually shallow.
+template <class T, unsigned N>
+class small_stack : public _stack_adapter<T, small_vector<T, N> > {};
+
 #endif  // _STL_STACK_H_
@@ -0,0 +1,192 @@
+// File: tests/allocator_test.cc
+
+#include "check.h"
+
+#include "allocator.h"
+#include "deque.h"
+#include "flat_map.h"
+#include "list.h"
+#include "map.h"
+#include "vector.h"
+
+// Global new and delete, counting the calls and the bytes outstanding.
+class counting_allocator : public allocator {
+ public:
+  unsigned calls;
+  long live;
+
+  counting_allocator() : calls(0), live(0) {}
+
+  void* allocate(unsigned bytes) {
+    calls++;
+    live += bytes;
+    return ::operator new(bytes);
+  }
+
+  void deallocate(void* p, unsigned bytes) {
+    live -= bytes;
+    ::operator delete(p);
+  }
+};
+
+static vector<pair<int, int> > sorted_items(int n) {
+  vector<pair<int, int> > items;
+  for (int i = 0; i < n; i++) items.push_back(make_pair(2 * i, i));
+  return items;
+}
+
+static void test_node_pool_reuse() {
+  node_pool pool(list<int>::node_size(), 4);
+  CHECK(pool.node_size() >= list<int>::node_size());
+  void* a = pool.allocate(list<int>::node_size());
+  void* b = pool.allocate(list<int>::node_size());
+  CHECK(a != b);
+  pool.deallocate(a, list<int>::node_size());
+  CHECK(pool.allocate(list<int>::node_size()) == a);
+  pool.deallocate(a, list<int>::node_size());
+  pool.deallocate(b, list<int>::node_size());
+
+  list<int> l(pool);
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 100; i++) l.push_back(i);
+    CHECK(l.size() == 100 && l.back() == 99);
+    l.clear();
+  }
+}
+
+// The single block of map::assign is far bigger than a node; it must go to
+// global new without changing the pool's block size.
+static void test_node_pool_bulk_block() {
+  node_pool pool(map<int, int>::node_size());
+  unsigned size = pool.node_size();
+  {
+    map<int, int> m(pool);
+    m.assign(sorted_items(1000));
+    CHECK(pool.node_size() == size);
+    for (int i = 0; i < 1000; i++) m.insert(2 * i + 1, i);
+    for (int i = 0; i < 1000; i += 3) m.erase(2 * i);
+    CHECK(m.valid());
+    CHECK(m.size() == 2000 - 334);
+    CHECK(m.at(1) == 0 && m.at(2) == 1);
+  }
+  CHECK(pool.node_size() == size);
+}
+
+static void test_copies() {
+  counting_allocator a;
+  {
+    vector<int> v(a);
+    list<int> l(a);
+    deque<int> d(a);
+    for (int i = 0; i < 10; i++) {
+      v.push_back(i);
+      l.push_back(i);
+      d.push_back(i);
+    }
+
+    // A copy allocates like its source...
+    unsigned before = a.calls;
+    vector<int> vc(v);
+    list<int> lc(l);
+    deque<int> dc(d);
+    CHECK(vc.get_allocator() == &a && vc.size() == 10);
+    CHECK(lc.get_allocator() == &a && lc.size() == 10);
+    CHECK(dc.get_allocator() == &a && dc.size() == 10);
+    CHECK(a.calls > before);
+
+    // ...and assignment keeps the target's allocator.
+    vector<int> va;
+    list<int> la;
+    deque<int> da;
+    before = a.calls;
+    va = v;
+    la = l;
+    da = d;
+    CHECK(!va.get_allocator() && va.size() == 10);
+    CHECK(!la.get_allocator() && la.size() == 10);
+    CHECK(!da.get_allocator() && da.size() == 10);
+    CHECK(a.calls == before);
+  }
+  CHECK(a.live == 0);
+}
+
+static int list_is(list<int>& l, const int* expect, unsigned n) {
+  if (l.size() != n) return 0;
+  unsigned i = 0;
+  for (list<int>::iterator it = l.begin(); it != l.end(); ++it)
+    if (*it != expect[i++]) return 0;
+  return 1;
+}
+
+// Nodes moved between lists with different allocators must end up owned by
+// the receiving list's allocator, and those of the same allocator must not
+// be copied.
+static void test_list_splice_across_allocators() {
+  counting_allocator a, b;
+  {
+    list<int> la(a), lb(b), lg;
+    for (int i = 0; i < 6; i++) la.push_back(i);
+    for (int i = 10; i < 13; i++) lb.push_back(i);
+
+    lb.splice(lb.begin(), la, la.begin());
+    list<int>::iterator second = la.begin();
+    ++second;
+    lb.splice(lb.end(), la, second, la.end());
+    static const int after_splice[] = {0, 10, 11, 12, 2, 3, 4, 5};
+    static const int left[] = {1};
+    CHECK(list_is(lb, after_splice, 8));
+    CHECK(list_is(la, left, 1));
+    CHECK(a.live == (long)list<int>::node_size());
+    CHECK(b.live == 8 * (long)list<int>::node_size());
+
+    lg.splice(lg.begin(), lb);
+    CHECK(lg.size() == 8 && lb.empty() && b.live == 0);
+
+    list<int> lc(a);
+    lc.push_back(3);
+    lc.push_back(7);
+    unsigned before = a.calls;
+    la.merge(lc);
+    static const int merged[] = {1, 3, 7};
+    CHECK(list_is(la, merged, 3) && lc.empty());
+    CHECK(a.calls == before);
+
+    lg.clear();
+    lg.push_back(0);
+    lg.push_back(5);
+    la.merge(lg);
+    static const int merged2[] = {0, 1, 3, 5, 7};
+    CHECK(list_is(la, merged2, 5) && lg.empty());
+    CHECK(a.live == 5 * (long)list<int>::node_size());
+  }
+  CHECK(a.live == 0 && b.live == 0);
+
+  node_pool p1(list<int>::node_size()), p2(list<int>::node_size());
+  list<int> l1(p1), l2(p2);
+  for (int i = 0; i < 100; i++) l1.push_back(i);
+  l2.splice(l2.end(), l1);
+  p1.release();
+  int sum = 0;
+  for (list<int>::iterator it = l2.begin(); it != l2.end(); ++it) sum += *it;
+  CHECK(sum == 4950);
+}
+
+static void test_flat_map() {
+  counting_allocator a;
+  {
+    flat_map<int, int> m(a);
+    CHECK(m.get_allocator() == &a);
+    for (int i = 0; i < 100; i++) m.insert(i, i);
+    CHECK(m.size() == 100 && a.calls > 0);
+  }
+  CHECK(a.live == 0);
+}
+
+int main() {
+  test_node_pool_reuse();
+  test_node_pool_bulk_block();
+  test_copies();
+  test_list_splice_across_allocators();
+  test_flat_map();
+  return check_result();
+}
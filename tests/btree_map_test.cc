@@ -0,0 +1,62 @@
+// File: tests/btree_map_test.cc
+
+#include "check.h"
+
+#include "btree_map.h"
+
+#include <map>
+#include <stdlib.h>
+
+typedef btree_map<int, int> int_btree_map;
+
+// Every key in [lo, hi) against std::map, then the whole order both ways.
+static void check_same(int_btree_map& m, std::map<int, int>& expect, int lo,
+                       int hi) {
+  CHECK(m.size() == expect.size());
+  for (int k = lo; k < hi; k++) {
+    std::map<int, int>::iterator e = expect.lower_bound(k);
+    int_btree_map::iterator it = m.lower_bound(k);
+    if (e == expect.end()) {
+      CHECK(it == m.end());
+    } else {
+      CHECK(it != m.end() && it->first == e->first &&
+            it->second == e->second);
+    }
+    CHECK((m.find(k) != m.end()) == (expect.find(k) != expect.end()));
+  }
+  std::map<int, int>::iterator e = expect.begin();
+  for (int_btree_map::iterator it = m.begin(); it != m.end(); ++it, ++e)
+    if (e == expect.end() || it->first != e->first) {
+      CHECK(e != expect.end() && it->first == e->first);
+      break;
+    }
+}
+
+// Enough keys for several levels of inner nodes, inserted and erased in
+// random order so that leaves and inner nodes split, borrow and merge.
+static void test_random_insert_erase() {
+  srand(1);
+  int_btree_map m;
+  std::map<int, int> expect;
+  const int kKeys = 20000;
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < 30000; i++) {
+      int k = rand() % kKeys;
+      // Grow in the even rounds, one erase in four, and shrink in the odd
+      // ones, three erases in four.
+      if (rand() % 4 < (round & 1 ? 3 : 1)) {
+        m.erase(k);
+        expect.erase(k);
+      } else {
+        m.insert(k, i);
+        expect[k] = i;
+      }
+    }
+    check_same(m, expect, -1, kKeys + 1);
+  }
+}
+
+int main() {
+  test_random_insert_erase();
+  return check_result();
+}
@@ -0,0 +1,28 @@
+// File: tests/check.h
+//
+// Description: The few macros the tests need. A failed CHECK reports the
+//              condition and keeps going; a test's main returns
+//              check_result(), which is nonzero if any check failed.
+
+#ifndef _STL_TESTS_CHECK_H_
+#define _STL_TESTS_CHECK_H_
+
+#include <stdio.h>
+
+static int check_failures = 0;
+
+#define CHECK(cond)                                                    \
+  do {                                                                 \
+    if (!(cond)) {                                                     \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+              #cond);                                                  \
+      check_failures++;                                                \
+    }                                                                  \
+  } while (0)
+
+inline int check_result() {
+  if (check_failures) fprintf(stderr, "%d checks failed\n", check_failures);
+  return check_failures ? 1 : 0;
+}
+
+#endif  // _STL_TESTS_CHECK_H_
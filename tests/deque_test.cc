@@ -0,0 +1,183 @@
+// File: tests/deque_test.cc
+
+#include "check.h"
+
+#include "deque.h"
+#include "queue.h"
+
+#include <deque>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+typedef deque<std::string> string_deque;
+
+template <class T>
+int same(deque<T>& d, std::deque<T>& expect) {
+  if (d.size() != expect.size()) return 0;
+  for (unsigned i = 0; i < d.size(); i++)
+    if (d[i] != expect[i]) return 0;
+  if (d.size() && (d.front() != expect.front() || d.back() != expect.back()))
+    return 0;
+  return 1;
+}
+
+// Nonzero if the live elements run off the end of the buffer and continue
+// at its start.
+template <class T>
+int is_wrapped(deque<T>& d) {
+  return d.size() > 1 && &d[d.size() - 1] < &d[0];
+}
+
+static std::string item(int i) {
+  char s[64];
+  sprintf(s, "element %d, long enough to allocate", i);
+  return s;
+}
+
+static int number(int i) { return i; }
+
+// Fills the buffer with its live run wrapped around the end, from either
+// side, then pushes once more so it grows; the copy must unwrap the run in
+// order. int takes grow()'s memcpy path, std::string the element-wise one.
+template <class T>
+void test_grow_wrapped(T (*make)(int)) {
+  int next = 0;
+  for (unsigned cap = 4; cap <= 64; cap += cap) {
+    for (unsigned shift = 1; shift < cap; shift++) {
+      for (int front = 0; front < 2; front++) {
+        deque<T> d;
+        std::deque<T> expect;
+        d.reserve(cap);
+        for (unsigned i = 0; i < shift; i++) {
+          d.push_back(make(next));
+          expect.push_back(make(next++));
+        }
+        for (unsigned i = 0; i < shift; i++) {
+          d.pop_front();
+          expect.pop_front();
+        }
+        while (d.size() < cap) {
+          d.push_back(make(next));
+          expect.push_back(make(next++));
+        }
+        CHECK(d.capacity() == cap && is_wrapped(d));
+        if (front) {
+          d.push_front(make(next));
+          expect.push_front(make(next++));
+        } else {
+          d.push_back(make(next));
+          expect.push_back(make(next++));
+        }
+        // After the copy only a push_front wraps, into the last slot.
+        CHECK(d.capacity() == cap + cap && is_wrapped(d) == front);
+        CHECK(same(d, expect));
+      }
+    }
+  }
+}
+
+// Pushing an element of the full deque onto itself: the value must be read
+// before grow() frees the old buffer.
+static void test_push_own_element() {
+  string_deque d;
+  std::deque<std::string> expect;
+  for (int i = 0; i < 200; i++) {
+    if (i % 2) {
+      d.push_front(d.back());
+      expect.push_front(expect.back());
+    } else if (d.empty()) {
+      d.push_back(item(i));
+      expect.push_back(item(i));
+    } else {
+      d.push_back(d.front());
+      expect.push_back(expect.front());
+    }
+    if (i % 3 == 0) {
+      d.push_back(item(i));
+      expect.push_back(item(i));
+    }
+  }
+  CHECK(same(d, expect));
+}
+
+// Random pushes and pops at both ends against std::deque, plus copies and
+// clear, so growth happens at every head position.
+static void test_random() {
+  string_deque d;
+  std::deque<std::string> expect;
+  int next = 0, grew_wrapped = 0;
+  for (int round = 0; round < 20000; round++) {
+    int wrapped = is_wrapped(d);
+    unsigned cap = d.capacity();
+    switch (rand() % 9) {
+      case 0:
+      case 1:
+        d.push_back(item(next));
+        expect.push_back(item(next++));
+        break;
+      case 2:
+      case 3:
+        d.push_front(item(next));
+        expect.push_front(item(next++));
+        break;
+      case 4:
+        d.pop_back();
+        if (!expect.empty()) expect.pop_back();
+        break;
+      case 5:
+      case 6:
+        d.pop_front();
+        if (!expect.empty()) expect.pop_front();
+        break;
+      case 7: {
+        string_deque copy(d);
+        CHECK(copy == d);
+        d = copy;
+        break;
+      }
+      default:
+        if (rand() % 50 == 0) {
+          d.clear();
+          expect.clear();
+        }
+        break;
+    }
+    grew_wrapped += wrapped && d.capacity() > cap;
+    if (!same(d, expect)) {
+      CHECK(same(d, expect));
+      return;
+    }
+  }
+  CHECK(grew_wrapped > 0);
+}
+
+// queue keeps FIFO order and front-to-back iteration across growth.
+static void test_queue() {
+  queue<int> q;
+  int pushed = 0, popped = 0;
+  for (int round = 0; round < 5000; round++) {
+    if (rand() % 3) {
+      q.push(pushed++);
+    } else if (!q.empty()) {
+      CHECK(q.front() == popped);
+      q.pop();
+      popped++;
+    }
+    CHECK(q.size() == (unsigned)(pushed - popped));
+  }
+  int expect = popped, ok = 1;
+  for (queue<int>::iterator it = q.begin(); it != q.end(); ++it)
+    ok &= *it == expect++;
+  CHECK(ok && expect == pushed);
+  if (!q.empty()) CHECK(q.back() == pushed - 1);
+}
+
+int main() {
+  test_grow_wrapped(number);
+  test_grow_wrapped(item);
+  test_push_own_element();
+  test_random();
+  test_queue();
+  return check_result();
+}
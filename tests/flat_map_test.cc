@@ -0,0 +1,66 @@
+// File: tests/flat_map_test.cc
+
+#include "check.h"
+
+#include "flat_map.h"
+
+#include <map>
+#include <stdlib.h>
+
+typedef flat_map<int, int> int_flat_map;
+
+// Every key in [lo, hi) against std::map: find, lower_bound and the order.
+static void check_same(int_flat_map& m, std::map<int, int>& expect, int lo,
+                       int hi) {
+  CHECK(m.size() == expect.size());
+  for (int k = lo; k < hi; k++) {
+    std::map<int, int>::iterator e = expect.lower_bound(k);
+    int_flat_map::iterator it = m.lower_bound(k);
+    if (e == expect.end()) {
+      CHECK(it == m.end());
+    } else {
+      CHECK(it != m.end() && it->first == e->first &&
+            it->second == e->second);
+    }
+    CHECK((m.find(k) != m.end()) == (expect.find(k) != expect.end()));
+  }
+}
+
+static void test_bulk_construction() {
+  srand(1);
+  for (int n = 0; n < 70; n++) {
+    vector<pair<int, int> > items;
+    std::map<int, int> expect;
+    for (int i = 0; i < n; i++) {
+      int k = rand() % 100;
+      items.push_back(make_pair(k, i));
+      // The first pair with a key survives.
+      expect.insert(std::make_pair(k, i));
+    }
+    int_flat_map m(items);
+    check_same(m, expect, -1, 101);
+  }
+}
+
+static void test_insert_erase() {
+  srand(2);
+  int_flat_map m;
+  std::map<int, int> expect;
+  for (int i = 0; i < 2000; i++) {
+    int k = rand() % 300;
+    if (rand() % 3) {
+      m.insert(k, i);
+      expect[k] = i;
+    } else {
+      m.erase(k);
+      expect.erase(k);
+    }
+  }
+  check_same(m, expect, -1, 301);
+}
+
+int main() {
+  test_bulk_construction();
+  test_insert_erase();
+  return check_result();
+}
@@ -0,0 +1,156 @@
+// File: tests/instantiate_test.cc
+//
+// Description: Instantiates every container and algorithm with the common
+//              operations, so that the build's warning flags see the
+//              template code itself and not just the declarations. Built
+//              once as is and once with STL_INSTRUMENT.
+
+#include "check.h"
+
+#include "algo.h"
+#include "btree_map.h"
+#include "deque.h"
+#include "flat_map.h"
+#include "hash.h"
+#include "intrusive_list.h"
+#include "list.h"
+#include "map.h"
+#include "parallel.h"
+#include "queue.h"
+#include "sharded_map.h"
+#include "small_vector.h"
+#include "spsc_ring.h"
+#include "stack.h"
+#include "unordered_map.h"
+#include "vector.h"
+#include "work_stealing_deque.h"
+
+struct job : list_hook {
+  int id;
+};
+
+struct add_one {
+  void operator()(int& x) { x++; }
+};
+
+struct noop_task : ws_task {
+  void run(work_stealing_scheduler&, int) {}
+};
+
+int main() {
+  vector<int> v;
+  for (int i = 0; i < 100; i++) v.push_back(100 - i);
+  vector<int> v2(v);
+  v2.insert(v2.begin() + 3, 7);
+  v2.erase(v2.begin(), v2.begin() + 2);
+  CHECK(v2.size() == 99);
+  sort(v.begin(), v.end());
+  CHECK(v[0] == 1 && v[99] == 100);
+  stable_sort(v.begin(), v.end());
+  heap_sort(v.begin(), v.end());
+  partial_sort(v.begin(), v.begin() + 10, v.end());
+  make_heap(v.begin(), v.end());
+  push_heap(v.begin(), v.end());
+  pop_heap(v.begin(), v.end());
+  sort_heap(v.begin(), v.end());
+  make_heap(v.data(), v.data() + v.size());
+  push_heap(v.data(), v.data() + v.size());
+  pop_heap(v.data(), v.data() + v.size());
+  sort_heap(v.data(), v.data() + v.size());
+  CHECK(find(v.data(), v.data() + v.size(), 5) != v.data() + v.size());
+  CHECK(count(v.begin(), v.end(), 5) == 1);
+  CHECK(accumulate(v.begin(), v.end(), 0) == 5050);
+  CHECK(*min_element(v.data(), v.data() + v.size()) == 1);
+
+  small_vector<int, 4> sv;
+  for (int i = 0; i < 10; i++) sv.push_back(i);
+  CHECK(sv.size() == 10);
+
+  list<int> l;
+  for (int i = 0; i < 10; i++) l.push_back(i);
+  list<int> l2(l);
+  l.splice(l.begin(), l2);
+  l.reverse();
+  CHECK(l.size() == 20 && l2.empty());
+  for (list<int>::reverse_iterator it = l.rbegin(); it != l.rend(); ++it) {
+  }
+
+  intrusive_list<job> jobs;
+  job j1, j2;
+  jobs.push_back(j1);
+  jobs.push_front(j2);
+  CHECK(jobs.size() == 2);
+  jobs.clear();
+
+  deque<int> d;
+  for (int i = 0; i < 10; i++) d.push_front(i);
+  CHECK(d.size() == 10 && d.back() == 0);
+
+  queue<int> q;
+  q.push(1);
+  q.pop();
+  stack<int> s;
+  s.push(1);
+  CHECK(s.top() == 1 && q.empty());
+  priority_queue<int> pq;
+  pq.push(3);
+  pq.push(1);
+  CHECK(pq.top() == 1);
+  indexed_priority_queue<int, 4> ipq;
+  indexed_priority_queue<int, 4>::handle h = ipq.push(5);
+  ipq.decrease_key(h, 2);
+  CHECK(ipq.top() == 2);
+
+  map<int, int> m;
+  for (int i = 0; i < 100; i++) m.insert(i * 7 % 100, i);
+  m.insert(m.end(), 1000, 0);
+  m.erase(50);
+  CHECK(m.valid() && m.size() == 100);
+  for (map<int, int>::iterator it = m.begin(); it != m.end(); ++it) {
+  }
+  for (map<int, int>::reverse_iterator it = m.rbegin(); it != m.rend();
+       ++it) {
+  }
+
+  flat_map<int, int> fm;
+  fm.insert(2, 2);
+  fm[1] = 1;
+  CHECK(fm.find(1) != fm.end() && fm.size() == 2);
+  btree_map<int, int> bm;
+  for (int i = 0; i < 1000; i++) bm.insert(i, i);
+  bm.erase(10);
+  CHECK(bm.size() == 999 && bm.find(10) == bm.end());
+  unordered_map<int, int> um;
+  for (int i = 0; i < 1000; i++) um[i] = i;
+  um.erase(10);
+  CHECK(um.size() == 999 && um.find(10) == um.end());
+
+  sharded_map<int, int> shm(8);
+  shm.insert(1, 1);
+  int val = 0;
+  CHECK(shm.find(1, val) && val == 1);
+
+  spsc_ring<int, 8> ring;
+  ring.push(1);
+  CHECK(ring.pop(val) && val == 1);
+  work_stealing_deque<int> wsd;
+  wsd.push(1);
+  CHECK(wsd.steal(val) && val == 1);
+  work_stealing_scheduler sched(1);
+  noop_task task;
+  sched.spawn(0, &task);
+  sched.run_worker(0);
+
+  parallel_for_each(default_executor(), v.begin(), v.end(), add_one());
+  parallel_sort(default_executor(), v.begin(), v.end());
+  CHECK(v[0] == 2);
+
+  monotonic_arena arena;
+  map<int, int> am(arena);
+  am.insert(1, 1);
+  node_pool pool(list<int>::node_size());
+  list<int> pl(pool);
+  pl.push_back(1);
+  CHECK(am.size() == 1 && pl.size() == 1);
+  return check_result();
+}
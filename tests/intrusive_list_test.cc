@@ -0,0 +1,151 @@
+// File: tests/intrusive_list_test.cc
+
+#include "check.h"
+
+#include "intrusive_list.h"
+
+#include <list>
+#include <stdlib.h>
+
+struct task : list_hook {
+  int id;
+};
+
+typedef intrusive_list<task> task_list;
+
+static const int kTasks = 32;
+
+// The ids on l front to back against expect, and walking back from end().
+static int same(task_list& l, std::list<int>& expect) {
+  if (l.size() != expect.size()) return 0;
+  std::list<int>::iterator e = expect.begin();
+  for (task_list::iterator it = l.begin(); it != l.end(); ++it, ++e)
+    if (it->id != *e) return 0;
+  std::list<int>::reverse_iterator r = expect.rbegin();
+  task_list::iterator it = l.end();
+  for (unsigned i = 0; i < l.size(); i++, ++r) {
+    --it;
+    if (it->id != *r) return 0;
+  }
+  return 1;
+}
+
+// Tasks move between two lists at random, unlinking themselves and being
+// linked again, against a std::list of ids per list.
+static void test_relink() {
+  task tasks[kTasks];
+  task_list lists[2];
+  std::list<int> expect[2];
+  // Which list each task is on, or -1.
+  int on[kTasks];
+  for (int i = 0; i < kTasks; i++) {
+    tasks[i].id = i;
+    on[i] = -1;
+  }
+
+  for (int round = 0; round < 20000; round++) {
+    int i = rand() % kTasks;
+    int l = rand() % 2;
+    task& t = tasks[i];
+    switch (rand() % 6) {
+      case 0:
+      case 1:
+        // Unlink from wherever it is, then link at either end of l.
+        if (on[i] >= 0) {
+          lists[on[i]].erase(t);
+          expect[on[i]].remove(i);
+        }
+        CHECK(!t.is_linked());
+        if (rand() & 1) {
+          lists[l].push_back(t);
+          expect[l].push_back(i);
+        } else {
+          lists[l].push_front(t);
+          expect[l].push_front(i);
+        }
+        on[i] = l;
+        break;
+      case 2:
+        // Link before a random element of l.
+        if (on[i] < 0 && !expect[l].empty()) {
+          int skip = rand() % expect[l].size();
+          task_list::iterator pos = lists[l].begin();
+          std::list<int>::iterator epos = expect[l].begin();
+          for (int k = 0; k < skip; k++, ++pos, ++epos) {
+          }
+          CHECK(lists[l].insert(pos, t)->id == i);
+          expect[l].insert(epos, i);
+          on[i] = l;
+        }
+        break;
+      case 3:
+        if (!expect[l].empty()) {
+          on[lists[l].front().id] = -1;
+          lists[l].pop_front();
+          expect[l].pop_front();
+        }
+        break;
+      case 4:
+        if (!expect[l].empty()) {
+          on[lists[l].back().id] = -1;
+          lists[l].pop_back();
+          expect[l].pop_back();
+        }
+        break;
+      default:
+        // Erase by iterator, checking the one returned.
+        if (on[i] >= 0) {
+          task_list& from = lists[on[i]];
+          task_list::iterator it = from.begin();
+          while (it->id != i) ++it;
+          task_list::iterator next = from.erase(it);
+          std::list<int>& ef = expect[on[i]];
+          std::list<int>::iterator e = ef.begin();
+          while (*e != i) ++e;
+          e = ef.erase(e);
+          CHECK(e == ef.end() ? next == from.end() : next->id == *e);
+          on[i] = -1;
+        }
+        break;
+    }
+    for (int k = 0; k < 2; k++) {
+      if (!same(lists[k], expect[k])) {
+        CHECK(same(lists[k], expect[k]));
+        return;
+      }
+    }
+  }
+  int linked = 0;
+  for (int i = 0; i < kTasks; i++) {
+    CHECK(tasks[i].is_linked() == (on[i] >= 0));
+    linked += tasks[i].is_linked();
+  }
+  CHECK((unsigned)linked == lists[0].size() + lists[1].size());
+
+  // clear() unlinks without touching the tasks otherwise.
+  lists[0].clear();
+  lists[1].clear();
+  for (int i = 0; i < kTasks; i++) CHECK(!tasks[i].is_linked());
+  CHECK(lists[0].empty() && lists[0].begin() == lists[0].end());
+}
+
+// A copy of a linked task starts out unlinked and can go on another list.
+static void test_copy_unlinked() {
+  task a;
+  a.id = 1;
+  task_list l, m;
+  l.push_back(a);
+  task b(a);
+  CHECK(a.is_linked() && !b.is_linked() && b.id == 1);
+  m.push_back(b);
+  b = a;
+  CHECK(b.is_linked() && &m.front() == &b);
+  l.clear();
+  m.clear();
+}
+
+int main() {
+  test_relink();
+  test_copy_unlinked();
+  return check_result();
+}
@@ -0,0 +1,156 @@
+// File: tests/list_test.cc
+
+#include "check.h"
+
+#include "list.h"
+
+#include <list>
+#include <stdlib.h>
+
+typedef list<int> int_list;
+
+// Orders by key alone, so a merge's stability shows in tag.
+struct item {
+  int key, tag;
+};
+
+static int operator<(const item& a, const item& b) { return a.key < b.key; }
+
+static item make_item(int key, int tag) {
+  item it;
+  it.key = key;
+  it.tag = tag;
+  return it;
+}
+
+template <class L, class It>
+It nth(L& l, It it, int n) {
+  for (int i = 0; i < n; i++) ++it;
+  return it;
+}
+
+// The contents against std::list front to back, back to front with
+// reverse_iterator, and back from end() with --.
+static int same(int_list& l, std::list<int>& expect) {
+  if (l.size() != expect.size()) return 0;
+  std::list<int>::iterator e = expect.begin();
+  for (int_list::iterator it = l.begin(); it != l.end(); ++it, ++e)
+    if (*it != *e) return 0;
+  std::list<int>::reverse_iterator r = expect.rbegin();
+  for (int_list::reverse_iterator it = l.rbegin(); it != l.rend(); ++it, ++r)
+    if (*it != *r) return 0;
+  int_list::iterator it = l.end();
+  for (r = expect.rbegin(); r != expect.rend(); ++r) {
+    --it;
+    if (*it != *r) return 0;
+  }
+  return 1;
+}
+
+// Random splices of single elements, ranges and whole lists, within one list
+// and between two, plus reverse, against std::list.
+static void test_splice_reverse() {
+  int_list l[2];
+  std::list<int> expect[2];
+  int next = 0;
+  for (int round = 0; round < 5000; round++) {
+    int a = rand() % 2, b = rand() % 2;
+    int na = expect[a].size(), nb = expect[b].size();
+    switch (rand() % 7) {
+      case 0:
+      case 1:
+        l[a].push_back(next);
+        expect[a].push_back(next++);
+        break;
+      case 2: {
+        // One element from b before a position in a.
+        if (!nb) break;
+        int from = rand() % nb, to = rand() % (na + 1);
+        l[a].splice(nth(l[a], l[a].begin(), to), l[b],
+                    nth(l[b], l[b].begin(), from));
+        expect[a].splice(nth(expect[a], expect[a].begin(), to), expect[b],
+                         nth(expect[b], expect[b].begin(), from));
+        break;
+      }
+      case 3: {
+        // [first, last) of b; within one list pos must lie outside it.
+        int first = rand() % (nb + 1);
+        int last = first + rand() % (nb - first + 1);
+        int to = rand() % (na + 1);
+        if (a == b && to >= first && to < last) break;
+        l[a].splice(nth(l[a], l[a].begin(), to), l[b],
+                    nth(l[b], l[b].begin(), first),
+                    nth(l[b], l[b].begin(), last));
+        expect[a].splice(nth(expect[a], expect[a].begin(), to), expect[b],
+                         nth(expect[b], expect[b].begin(), first),
+                         nth(expect[b], expect[b].begin(), last));
+        break;
+      }
+      case 4:
+        if (a != b) {
+          int to = rand() % (na + 1);
+          l[a].splice(nth(l[a], l[a].begin(), to), l[b]);
+          expect[a].splice(nth(expect[a], expect[a].begin(), to), expect[b]);
+        }
+        break;
+      case 5:
+        l[a].reverse();
+        expect[a].reverse();
+        break;
+      default:
+        if (na) {
+          int at = rand() % na;
+          l[a].erase(nth(l[a], l[a].begin(), at));
+          expect[a].erase(nth(expect[a], expect[a].begin(), at));
+        }
+        break;
+    }
+    for (int k = 0; k < 2; k++) {
+      if (!same(l[k], expect[k])) {
+        CHECK(same(l[k], expect[k]));
+        return;
+      }
+    }
+  }
+}
+
+// Merges sorted lists with repeated keys; the result must equal std::list's
+// stable merge, ties keeping this list's elements first.
+static void test_merge() {
+  for (int round = 0; round < 200; round++) {
+    std::list<item> ea, eb;
+    int na = rand() % 30, nb = rand() % 30;
+    for (int i = 0; i < na; i++) ea.push_back(make_item(rand() % 10, i));
+    for (int i = 0; i < nb; i++) eb.push_back(make_item(rand() % 10, 100 + i));
+    ea.sort();
+    eb.sort();
+    list<item> a, b;
+    for (std::list<item>::iterator it = ea.begin(); it != ea.end(); ++it)
+      a.push_back(*it);
+    for (std::list<item>::iterator it = eb.begin(); it != eb.end(); ++it)
+      b.push_back(*it);
+
+    a.merge(b);
+    ea.merge(eb);
+    CHECK(b.empty() && a.size() == ea.size());
+    std::list<item>::iterator e = ea.begin();
+    int ok = 1;
+    for (list<item>::iterator it = a.begin(); it != a.end(); ++it, ++e)
+      ok &= it->key == e->key && it->tag == e->tag;
+    CHECK(ok);
+    // Backwards too, so the prev links are right.
+    list<item>::iterator it = a.end();
+    for (std::list<item>::reverse_iterator r = ea.rbegin(); r != ea.rend();
+         ++r) {
+      --it;
+      ok &= it->tag == r->tag;
+    }
+    CHECK(ok);
+  }
+}
+
+int main() {
+  test_splice_reverse();
+  test_merge();
+  return check_result();
+}
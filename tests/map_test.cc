@@ -0,0 +1,136 @@
+// File: tests/map_test.cc
+
+#include "check.h"
+
+#include "map.h"
+
+#include <map>
+#include <stdlib.h>
+
+typedef map<int, int> int_map;
+
+// The contents in order against std::map.
+static int same(int_map& m, std::map<int, int>& expect) {
+  if (m.size() != expect.size()) return 0;
+  std::map<int, int>::iterator e = expect.begin();
+  for (int_map::iterator it = m.begin(); it != m.end(); ++it, ++e)
+    if (it->first != e->first || it->second != e->second) return 0;
+  return 1;
+}
+
+// A hint for key: the right one (the first element greater than key), or a
+// wrong one to check that hinted inserts fall back to a full descent.
+static int_map::iterator hint_for(int_map& m, int key) {
+  switch (rand() % 4) {
+    case 0:
+      return m.begin();
+    case 1:
+      return m.end();
+    case 2:
+      return m.find(key + 1 + rand() % 3);
+  }
+  int_map::iterator it = m.begin();
+  while (it != m.end() && it->first <= key) ++it;
+  return it;
+}
+
+// One random insert, hinted insert, operator[] or erase, mirrored in expect.
+static void random_op(int_map& m, std::map<int, int>& expect, int keys,
+                      int val) {
+  int k = rand() % keys;
+  switch (rand() % 5) {
+    case 0:
+      m.insert(k, val);
+      expect[k] = val;
+      break;
+    case 1:
+      m.insert(hint_for(m, k), k, val);
+      expect[k] = val;
+      break;
+    case 2:
+      m[k] = val;
+      expect[k] = val;
+      break;
+    default:
+      m.erase(k);
+      expect.erase(k);
+  }
+}
+
+static void test_random_ops() {
+  srand(1);
+  int_map m;
+  std::map<int, int> expect;
+  for (int i = 0; i < 5000; i++) {
+    random_op(m, expect, i < 2500 ? 400 : 40, i);
+    CHECK(m.valid());
+  }
+  CHECK(same(m, expect));
+  while (!expect.empty()) {
+    int k = expect.begin()->first;
+    m.erase(k);
+    expect.erase(k);
+    CHECK(m.valid());
+  }
+  CHECK(m.empty());
+}
+
+// Erasing keys that aren't there takes the same single descent as a hit and
+// must leave the tree as it was.
+static void test_erase_missing() {
+  vector<pair<int, int> > sorted;
+  for (int i = 0; i < 1000; i++) sorted.push_back(make_pair(2 * i, i));
+  int_map m(sorted);
+  for (int k = -1; k <= 2001; k += 2) {
+    m.erase(k);
+    CHECK(m.valid() && m.size() == 1000);
+  }
+  // Half of the keys, then the same keys again once they are gone.
+  for (int pass = 0; pass < 2; pass++) {
+    for (int k = 0; k < 2000; k += 4) m.erase(k);
+    CHECK(m.valid() && m.size() == 500);
+  }
+}
+
+// Ascending keys hinted at end(), the pattern the hint is for.
+static void test_hinted_append() {
+  int_map m;
+  for (int i = 0; i < 1000; i++) {
+    int_map::iterator it = m.insert(m.end(), i, -i);
+    CHECK(it->first == i);
+  }
+  CHECK(m.valid() && m.size() == 1000);
+}
+
+// assign() of every size up to 130, crossing several black heights, then
+// random operations on the built tree, whose nodes share one block.
+static void test_assign() {
+  srand(2);
+  for (int n = 0; n <= 130; n++) {
+    vector<pair<int, int> > sorted;
+    std::map<int, int> expect;
+    for (int i = 0; i < n; i++) {
+      sorted.push_back(make_pair(2 * i, i));
+      expect[2 * i] = i;
+    }
+    int_map m(sorted);
+    CHECK(m.valid());
+    CHECK(same(m, expect));
+    for (int i = 0; i < 200; i++) {
+      random_op(m, expect, 2 * n + 2, i);
+      CHECK(m.valid());
+    }
+    CHECK(same(m, expect));
+    // Reassigning replaces the contents and frees the old block.
+    m.assign(sorted);
+    CHECK(m.valid() && m.size() == (unsigned)n);
+  }
+}
+
+int main() {
+  test_random_ops();
+  test_hinted_append();
+  test_erase_missing();
+  test_assign();
+  return check_result();
+}
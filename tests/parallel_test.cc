@@ -0,0 +1,128 @@
+// File: tests/parallel_test.cc
+
+#include "check.h"
+
+#include "parallel.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <vector>
+
+// Grains below 1 count as 1; the rest cover one chunk per element up to a
+// single chunk for the whole range.
+static const int kGrains[] = {-1, 0, 1, 3, 64, 100000};
+static const int kSizes[] = {0, 1, 2, 17, 1000, 5000};
+
+static int is_min_heap(const vector<int>& v) {
+  for (unsigned i = 1; i < v.size(); i++)
+    if (v[i] < v[(i - 1) / 2]) return 0;
+  return 1;
+}
+
+static void random_fill(vector<int>& v, int n) {
+  v.clear();
+  for (int i = 0; i < n; i++) v.push_back(rand() % (n + 1));
+}
+
+struct add_one {
+  void operator()(int& x) const { x++; }
+};
+
+struct twice {
+  int operator()(int x) const { return 2 * x; }
+};
+
+struct plus_double {
+  double operator()(double a, double b) const { return a + b; }
+};
+
+static void test_executor(executor& ex) {
+  srand(1);
+  for (unsigned s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); s++) {
+    int n = kSizes[s];
+    for (unsigned g = 0; g < sizeof(kGrains) / sizeof(kGrains[0]); g++) {
+      int grain = kGrains[g];
+      vector<int> v;
+      random_fill(v, n);
+      std::vector<int> expect(v.data(), v.data() + n);
+      std::sort(expect.begin(), expect.end());
+      parallel_sort(ex, v.begin(), v.end(), grain);
+      CHECK(std::equal(expect.begin(), expect.end(), v.data()));
+
+      random_fill(v, n);
+      parallel_make_heap(ex, v.begin(), v.end(), grain);
+      CHECK(is_min_heap(v));
+
+      parallel_for_each(ex, v.begin(), v.end(), add_one(), grain);
+      vector<int> out;
+      out.resize(n);
+      parallel_transform(ex, v.begin(), v.end(), out.begin(), twice(), grain);
+      int ok = 1;
+      for (int i = 0; i < n; i++) ok &= out[i] == 2 * v[i];
+      CHECK(ok);
+    }
+  }
+}
+
+// An int on the heap, so that a copy the sort's merge buffer fails to
+// construct or destroy shows up as a crash or a leak.
+struct boxed {
+  int* p;
+
+  boxed(int x) : p(new int(x)) {}
+  boxed(const boxed& b) : p(new int(*b.p)) {}
+  ~boxed() { delete p; }
+
+  boxed& operator=(const boxed& b) {
+    *p = *b.p;
+    return *this;
+  }
+};
+
+static int operator<(const boxed& a, const boxed& b) { return *a.p < *b.p; }
+
+static void test_sort_boxed(executor& ex) {
+  vector<boxed> v;
+  std::vector<int> expect;
+  for (int i = 0; i < 3000; i++) {
+    expect.push_back(rand() % 1000);
+    v.push_back(boxed(expect.back()));
+  }
+  std::sort(expect.begin(), expect.end());
+  parallel_sort(ex, v.begin(), v.end(), 100);
+  int ok = 1;
+  for (int i = 0; i < 3000; i++) ok &= *v[i].p == expect[i];
+  CHECK(ok);
+}
+
+// The grouping of a reduction depends on grain alone, so a floating point
+// sum is the same on every executor.
+static void test_reduce_deterministic(executor& ex) {
+  vector<double> v;
+  for (int i = 0; i < 10000; i++) v.push_back(1.0 / (1 + i % 97) + i * 1e-7);
+  for (unsigned g = 0; g < sizeof(kGrains) / sizeof(kGrains[0]); g++) {
+    int grain = kGrains[g];
+    serial_executor serial;
+    double expect =
+        parallel_reduce(serial, v.begin(), v.end(), 0.5, plus_double(), grain);
+    double sum =
+        parallel_reduce(ex, v.begin(), v.end(), 0.5, plus_double(), grain);
+    CHECK(sum == expect);
+  }
+}
+
+int main() {
+  serial_executor serial;
+  test_executor(serial);
+  test_reduce_deterministic(serial);
+  test_sort_boxed(serial);
+#ifdef _REENTRANT
+  thread_pool pool(4);
+  CHECK(pool.threads() == 4);
+  test_executor(pool);
+  test_reduce_deterministic(pool);
+  test_sort_boxed(pool);
+#endif
+  return check_result();
+}
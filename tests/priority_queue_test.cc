@@ -0,0 +1,180 @@
+// File: tests/priority_queue_test.cc
+
+#include "check.h"
+
+#include "queue.h"
+
+#include <functional>
+#include <map>
+#include <queue>
+#include <set>
+#include <stdlib.h>
+#include <utility>
+#include <vector>
+
+// Random pushes and pops against std::priority_queue, starting from a
+// heapified vector.
+template <unsigned D>
+void test_d_ary(d_ary_priority_queue<int, D>*) {
+  vector<int> items;
+  std::vector<int> start;
+  for (int i = 0; i < 300; i++) {
+    items.push_back(rand() % 1000);
+    start.push_back(items.back());
+  }
+  d_ary_priority_queue<int, D> q(items);
+  std::priority_queue<int, std::vector<int>, std::greater<int> > expect(
+      start.begin(), start.end());
+  for (int round = 0; round < 20000; round++) {
+    if (rand() % 2) {
+      int val = rand() % 1000;
+      q.push(val);
+      expect.push(val);
+    } else if (!expect.empty()) {
+      q.pop();
+      expect.pop();
+    }
+    if (q.size() != expect.size() || (!q.empty() && q.top() != expect.top())) {
+      CHECK(q.size() == expect.size() && q.top() == expect.top());
+      return;
+    }
+  }
+  // Drains in order.
+  while (!expect.empty()) {
+    if (q.top() != expect.top()) break;
+    q.pop();
+    expect.pop();
+  }
+  CHECK(expect.empty() && q.empty());
+}
+
+typedef std::set<std::pair<int, unsigned> > reference_heap;
+
+// The queue against a model: the value of each live handle, and the
+// (value, handle) pairs in order, whose first is the minimum.
+template <unsigned D>
+int same(indexed_priority_queue<int, D>& q, std::map<unsigned, int>& values,
+         reference_heap& order) {
+  if (q.size() != values.size()) return 0;
+  for (std::map<unsigned, int>::iterator it = values.begin();
+       it != values.end(); ++it)
+    if (!q.contains(it->first) || q[it->first] != it->second) return 0;
+  // Ties may come out by any handle, but the handle must hold the minimum.
+  if (!q.empty() && (q.top() != order.begin()->first ||
+                     values[q.top_handle()] != q.top()))
+    return 0;
+  return 1;
+}
+
+// Random pushes, pops, decrease_key, update and erase against the model,
+// keeping removed handles to check they read as free until reused.
+template <unsigned D>
+void test_indexed(indexed_priority_queue<int, D>*) {
+  indexed_priority_queue<int, D> q;
+  std::map<unsigned, int> values;
+  reference_heap order;
+  std::vector<unsigned> live;
+  int decreased = 0, erased_inside = 0;
+  for (int round = 0; round < 20000; round++) {
+    int op = rand() % 8;
+    if (live.empty()) op = 0;
+    unsigned at = live.empty() ? 0 : rand() % live.size();
+    unsigned h = live.empty() ? 0 : live[at];
+    switch (op) {
+      case 0:
+      case 1: {
+        int val = rand() % 1000;
+        unsigned nh = q.push(val);
+        CHECK(!values.count(nh));
+        values[nh] = val;
+        order.insert(std::make_pair(val, nh));
+        live.push_back(nh);
+        break;
+      }
+      case 2: {
+        unsigned top = q.top_handle();
+        q.pop();
+        order.erase(std::make_pair(values[top], top));
+        values.erase(top);
+        for (unsigned i = 0; i < live.size(); i++)
+          if (live[i] == top) {
+            live[i] = live.back();
+            live.pop_back();
+            break;
+          }
+        CHECK(!q.contains(top));
+        break;
+      }
+      case 3:
+      case 4: {
+        // By up to a few hundred, so it often passes its parent.
+        int val = values[h] - rand() % 300;
+        q.decrease_key(h, val);
+        order.erase(std::make_pair(values[h], h));
+        values[h] = val;
+        order.insert(std::make_pair(val, h));
+        decreased++;
+        break;
+      }
+      case 5: {
+        int val = rand() % 1000;
+        q.update(h, val);
+        order.erase(std::make_pair(values[h], h));
+        values[h] = val;
+        order.insert(std::make_pair(val, h));
+        break;
+      }
+      default:
+        // Erasing from the middle moves the last element into the hole,
+        // which may then have to go up or down.
+        erased_inside += h != q.top_handle();
+        q.erase(h);
+        order.erase(std::make_pair(values[h], h));
+        values.erase(h);
+        live[at] = live.back();
+        live.pop_back();
+        CHECK(!q.contains(h));
+        break;
+    }
+    if (!same(q, values, order)) {
+      CHECK(same(q, values, order));
+      return;
+    }
+  }
+  CHECK(decreased > 0 && erased_inside > 0);
+  // Drains in order, each handle freed as it goes.
+  int ok = 1;
+  while (!q.empty()) {
+    unsigned top = q.top_handle();
+    ok &= q.top() == order.begin()->first && values[top] == q.top();
+    order.erase(std::make_pair(values[top], top));
+    q.pop();
+    ok &= !q.contains(top);
+  }
+  CHECK(ok && order.empty());
+}
+
+// Decreasing a key to a value it already holds, and to an element's own
+// value read through operator[].
+static void test_decrease_to_own_value() {
+  indexed_priority_queue<int, 4> q;
+  unsigned h[20];
+  for (int i = 0; i < 20; i++) h[i] = q.push(100 - i);
+  q.decrease_key(h[5], q[h[5]]);
+  q.decrease_key(h[7], q[h[19]]);
+  CHECK(q[h[5]] == 95 && q[h[7]] == 81);
+  q.decrease_key(h[0], q[h[19]] - 1);
+  CHECK(q.top() == 80 && q.top_handle() == h[0]);
+}
+
+int main() {
+  test_d_ary((d_ary_priority_queue<int, 2>*)0);
+  test_d_ary((d_ary_priority_queue<int, 3>*)0);
+  test_d_ary((d_ary_priority_queue<int, 8>*)0);
+  test_indexed((indexed_priority_queue<int, 2>*)0);
+  test_indexed((indexed_priority_queue<int, 3>*)0);
+  test_indexed((indexed_priority_queue<int, 4>*)0);
+  test_indexed((indexed_priority_queue<int, 8>*)0);
+  test_decrease_to_own_value();
+  return check_result();
+}
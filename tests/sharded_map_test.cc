@@ -0,0 +1,204 @@
+// File: tests/sharded_map_test.cc
+
+#include "check.h"
+
+#include "sharded_map.h"
+
+#include <stdlib.h>
+
+#ifdef _REENTRANT
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// A value that belongs to key, so a reader can tell a torn or misplaced one.
+static unsigned value_for(unsigned key, unsigned version) {
+  return key * 2654435761u ^ version << 24;
+}
+
+static unsigned key_of(unsigned key, unsigned val) {
+  return (val ^ key * 2654435761u) & 0xFFFFFFu;
+}
+
+struct add_one {
+  void operator()(unsigned& x) const { x++; }
+};
+
+static void test_single_thread() {
+  sharded_map<unsigned, unsigned> m(5);
+  CHECK(m.shard_count() == 8);
+  unsigned v;
+  CHECK(!m.find(1, v));
+  CHECK(m.insert(1, 10));
+  CHECK(!m.insert(1, 11));
+  CHECK(m.find(1, v) && v == 11);
+  CHECK(m.contains(1) && !m.contains(2));
+  for (unsigned k = 0; k < 1000; k++) m.insert(k, value_for(k, 0));
+  CHECK(m.size() == 1000);
+  CHECK(m.erase(500) && !m.erase(500));
+  CHECK(update(m, 2000u, add_one()) && !update(m, 2000u, add_one()));
+  CHECK(m.find(2000, v) && v == 2);
+  m.clear();
+  CHECK(m.size() == 0);
+}
+
+#ifdef _REENTRANT
+
+static const int kThreads = 4;
+static const unsigned kKeysPerThread = 2000;
+static const unsigned kRounds = 30000;
+static const unsigned kCounters = 16;
+static const unsigned kCounterBase = 1u << 20;
+
+struct count_pairs {
+  unsigned* n;
+  unsigned* bad;
+
+  // Keys from kCounterBase up are counters, not value_for() values.
+  void operator()(const pair<unsigned, unsigned>& kv) const {
+    (*n)++;
+    if (kv.first < kCounterBase && key_of(kv.first, kv.second)) (*bad)++;
+  }
+};
+
+static sharded_map<unsigned, unsigned>* shared;
+static unsigned bad_reads;
+
+// Thread t owns keys t, t + kThreads, ... and inserts and erases only those,
+// keeping its own picture of which are present; it looks up any key, and
+// bumps counters that every thread shares.
+static void* worker(void* arg) {
+  unsigned t = (unsigned)(long)arg;
+  unsigned seed = t * 7919 + 1;
+  unsigned char present[kKeysPerThread] = {0};
+  unsigned version[kKeysPerThread] = {0};
+  unsigned bad = 0;
+  for (unsigned r = 0; r < kRounds; r++) {
+    seed = seed * 1103515245u + 12345u;
+    unsigned i = (seed >> 8) % kKeysPerThread;
+    unsigned key = i * kThreads + t;
+    unsigned v;
+    switch ((seed >> 4) % 5) {
+      case 0:
+        version[i] = (version[i] + 1) & 0xFF;
+        if (shared->insert(key, value_for(key, version[i])) == present[i])
+          bad++;
+        present[i] = 1;
+        break;
+      case 1:
+        if (shared->erase(key) != present[i]) bad++;
+        present[i] = 0;
+        break;
+      case 2:
+        if (shared->find(key, v) != present[i] ||
+            (present[i] && v != value_for(key, version[i])))
+          bad++;
+        break;
+      case 3: {
+        // Another thread's key: present or not, its value must be its own.
+        unsigned other = (seed >> 12) % (kKeysPerThread * kThreads);
+        if (shared->find(other, v) && key_of(other, v)) bad++;
+        break;
+      }
+      default:
+        update(*shared, kCounterBase + (seed >> 16) % kCounters, add_one());
+        break;
+    }
+    if (!(r & 1023)) sched_yield();
+  }
+  // Leaves exactly its present keys, for the final count.
+  for (unsigned i = 0; i < kKeysPerThread; i++)
+    if (present[i] != shared->contains(i * kThreads + t)) bad++;
+  atomic_fetch_add(&bad_reads, bad);
+  return 0;
+}
+
+static void test_threads() {
+  sharded_map<unsigned, unsigned> m(16);
+  shared = &m;
+  pthread_t threads[kThreads];
+  for (long t = 0; t < kThreads; t++)
+    pthread_create(&threads[t], 0, worker, (void*)t);
+
+  // The main thread walks the map meanwhile.
+  unsigned n = 0, bad = 0;
+  count_pairs fn = {&n, &bad};
+  for (int i = 0; i < 20; i++) {
+    for_each(m, fn);
+    sched_yield();
+  }
+  for (int t = 0; t < kThreads; t++) pthread_join(threads[t], 0);
+  CHECK(!bad_reads);
+  CHECK(!bad);
+
+  // Every counter bump landed: the counters add up to the number of rounds
+  // that bumped one, which the workers' seeds determine.
+  unsigned long bumps = 0;
+  for (unsigned c = 0; c < kCounters; c++) {
+    unsigned v = 0;
+    m.find(kCounterBase + c, v);
+    bumps += v;
+  }
+  unsigned long expect = 0;
+  for (unsigned t = 0; t < (unsigned)kThreads; t++) {
+    unsigned seed = t * 7919 + 1;
+    for (unsigned r = 0; r < kRounds; r++) {
+      seed = seed * 1103515245u + 12345u;
+      if ((seed >> 4) % 5 == 4) expect++;
+    }
+  }
+  CHECK(bumps == expect);
+
+  unsigned counters = 0;
+  for (unsigned c = 0; c < kCounters; c++)
+    counters += m.contains(kCounterBase + c);
+  unsigned keys = 0;
+  for (unsigned k = 0; k < kKeysPerThread * kThreads; k++) keys += m.contains(k);
+  CHECK(m.size() == keys + counters);
+}
+
+// Readers must never see a write half done.
+static rw_spinlock lock;
+static volatile unsigned long guarded[2];
+static volatile int stop_readers;
+
+static void* lock_reader(void*) {
+  unsigned long torn = 0;
+  while (!atomic_load_acquire(&stop_readers)) {
+    lock.lock_shared();
+    if (guarded[0] != guarded[1]) torn++;
+    lock.unlock_shared();
+  }
+  return (void*)torn;
+}
+
+static void test_rw_spinlock() {
+  pthread_t readers[3];
+  for (int i = 0; i < 3; i++) pthread_create(&readers[i], 0, lock_reader, 0);
+  for (unsigned long i = 0; i < 100000; i++) {
+    lock.lock();
+    guarded[0] = i;
+    if (!(i & 255)) sched_yield();
+    guarded[1] = i;
+    lock.unlock();
+  }
+  atomic_store_release(&stop_readers, 1);
+  unsigned long torn = 0;
+  for (int i = 0; i < 3; i++) {
+    void* r;
+    pthread_join(readers[i], &r);
+    torn += (unsigned long)r;
+  }
+  CHECK(!torn);
+}
+
+#endif  // _REENTRANT
+
+int main() {
+  test_single_thread();
+#ifdef _REENTRANT
+  test_threads();
+  test_rw_spinlock();
+#endif
+  return check_result();
+}
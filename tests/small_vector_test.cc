@@ -0,0 +1,110 @@
+// File: tests/small_vector_test.cc
+
+#include "check.h"
+
+#include "small_vector.h"
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+typedef small_vector<std::string, 4> small_strings;
+
+// Nonzero if v's elements are in its inline buffer.
+template <class V>
+int is_inline(V& v) {
+  const char* p = (const char*)v.data();
+  return p >= (const char*)&v && p < (const char*)(&v + 1);
+}
+
+static int same(vector<std::string>& v, std::vector<std::string>& expect) {
+  if (v.size() != expect.size()) return 0;
+  for (unsigned i = 0; i < v.size(); i++)
+    if (v[i] != expect[i]) return 0;
+  return 1;
+}
+
+static std::string item(int i) {
+  char s[64];
+  sprintf(s, "element %d, long enough to allocate", i);
+  return s;
+}
+
+// Random edits against std::vector, the size wandering across N so the
+// elements spill to the heap and, on shrink_to_fit, come back.
+static void test_random() {
+  small_strings v;
+  std::vector<std::string> expect;
+  CHECK(is_inline(v) && v.capacity() == 4);
+  int spilled = 0, returned = 0;
+  for (int round = 0; round < 4000; round++) {
+    int target = round / 200 % 2 ? 2 : 9;
+    int op = rand() % 6;
+    if (op < 2 && (int)expect.size() < target + 3) {
+      std::string s = item(round);
+      v.push_back(s);
+      expect.push_back(s);
+    } else if (op == 2 && !expect.empty()) {
+      v.pop_back();
+      expect.pop_back();
+    } else if (op == 3) {
+      unsigned pos = rand() % (expect.size() + 1);
+      std::string s = item(-round);
+      v.insert(v.begin() + pos, s);
+      expect.insert(expect.begin() + pos, s);
+    } else if (op == 4 && !expect.empty()) {
+      unsigned pos = rand() % expect.size();
+      v.erase(v.begin() + pos);
+      expect.erase(expect.begin() + pos);
+    } else {
+      int was_inline = is_inline(v);
+      v.shrink_to_fit();
+      if (expect.size() <= 4) {
+        CHECK(is_inline(v) && v.capacity() == 4);
+        if (!was_inline) returned++;
+      } else {
+        CHECK(!is_inline(v) && v.capacity() == expect.size());
+      }
+    }
+    if (expect.size() > 4) {
+      CHECK(!is_inline(v));
+      spilled++;
+    }
+    if (!same(v, expect)) {
+      CHECK(same(v, expect));
+      break;
+    }
+  }
+  CHECK(spilled && returned);
+}
+
+static void test_copies() {
+  small_strings big;
+  for (int i = 0; i < 10; i++) big.push_back(item(i));
+  CHECK(!is_inline(big));
+
+  // Copies start inline, and spill only if the source doesn't fit.
+  small_strings copy(big);
+  CHECK(!is_inline(copy) && copy.size() == 10 && copy[9] == item(9));
+  while (big.size() > 3) big.pop_back();
+  small_strings small(big);
+  CHECK(is_inline(small) && small.size() == 3 && small[2] == item(2));
+
+  copy = small;
+  CHECK(copy.size() == 3 && copy[0] == item(0));
+  copy.shrink_to_fit();
+  CHECK(is_inline(copy) && copy[1] == item(1));
+
+  // As a plain vector, shrink_to_fit is vector's and stays on the heap.
+  vector<std::string>& as_vector = big;
+  as_vector.shrink_to_fit();
+  CHECK(!is_inline(big) && big.capacity() == 3);
+  big.shrink_to_fit();
+  CHECK(is_inline(big) && big.size() == 3 && big[2] == item(2));
+}
+
+int main() {
+  test_random();
+  test_copies();
+  return check_result();
+}
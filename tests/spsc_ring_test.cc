@@ -0,0 +1,134 @@
+// File: tests/spsc_ring_test.cc
+
+#include "check.h"
+
+#include "spsc_ring.h"
+
+#ifdef _REENTRANT
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Two words, so a slot read before the producer finished writing it shows up
+// as a mismatch.
+struct item {
+  unsigned seq;
+  unsigned check;
+};
+
+static item make_item(unsigned seq) {
+  item it;
+  it.seq = seq;
+  it.check = seq * 2654435761u;
+  return it;
+}
+
+typedef spsc_ring<item, 64> ring;
+
+static void test_single_thread() {
+  static ring r;
+  item it;
+  CHECK(r.empty());
+  CHECK(!r.pop(it));
+  CHECK(r.capacity() == 64);
+
+  unsigned i;
+  for (i = 0; i < 64; i++) CHECK(r.push(make_item(i)));
+  CHECK(!r.push(make_item(64)));
+  CHECK(r.size() == 64);
+
+  // Around the end of the buffer a few times, single and batched.
+  unsigned next_in = 64, next_out = 0;
+  item batch[40];
+  for (int round = 0; round < 10; round++) {
+    unsigned n = r.pop(batch, 40);
+    CHECK(n == 40);
+    for (i = 0; i < n; i++) CHECK(batch[i].seq == next_out++);
+    for (i = 0; i < 40; i++) batch[i] = make_item(next_in + i);
+    CHECK(r.push(batch, 40) == 40);
+    next_in += 40;
+    CHECK(r.push(batch, 1) == 0);
+    CHECK(r.pop(it) && it.seq == next_out++);
+    CHECK(r.push(make_item(next_in++)));
+  }
+  while (r.pop(it)) CHECK(it.seq == next_out++);
+  CHECK(next_out == next_in);
+  CHECK(r.empty());
+
+  // A batch bigger than the room left is cut short, not dropped.
+  for (i = 0; i < 40; i++) batch[i] = make_item(i);
+  CHECK(r.push(batch, 40) == 40);
+  CHECK(r.push(batch, 40) == 24);
+  CHECK(r.pop(batch, 40) == 40);
+  CHECK(r.pop(batch, 40) == 24);
+  CHECK(r.pop(batch, 40) == 0);
+}
+
+#ifdef _REENTRANT
+
+static const unsigned kCount = 1000000;
+
+static ring shared;
+
+// Alternates single pushes with batches of 1 to 37 items, yielding whenever
+// the ring is full so the test also finishes on one core.
+static void* producer(void*) {
+  item batch[37];
+  unsigned seq = 0, step = 0;
+  while (seq < kCount) {
+    unsigned n = ++step % 37 + 1;
+    if (n > kCount - seq) n = kCount - seq;
+    if (step & 1) {
+      if (shared.push(make_item(seq)))
+        seq++;
+      else
+        sched_yield();
+    } else {
+      for (unsigned i = 0; i < n; i++) batch[i] = make_item(seq + i);
+      unsigned done = 0;
+      while (done < n) {
+        unsigned pushed = shared.push(batch + done, n - done);
+        if (!pushed) sched_yield();
+        done += pushed;
+      }
+      seq += n;
+    }
+  }
+  return 0;
+}
+
+static void test_producer_consumer() {
+  pthread_t thread;
+  pthread_create(&thread, 0, producer, 0);
+
+  item batch[29];
+  unsigned next = 0, bad = 0, step = 0;
+  while (next < kCount) {
+    unsigned n;
+    if (++step & 1) {
+      n = shared.pop(batch[0]);
+    } else {
+      n = shared.pop(batch, step % 29 + 1);
+    }
+    if (!n) sched_yield();
+    for (unsigned i = 0; i < n; i++) {
+      if (batch[i].seq != next || batch[i].check != next * 2654435761u) bad++;
+      next++;
+    }
+  }
+  pthread_join(thread, 0);
+
+  CHECK(!bad);
+  CHECK(next == kCount);
+  CHECK(shared.empty());
+}
+
+#endif  // _REENTRANT
+
+int main() {
+  test_single_thread();
+#ifdef _REENTRANT
+  test_producer_consumer();
+#endif
+  return check_result();
+}
@@ -0,0 +1,130 @@
+// File: tests/unordered_map_test.cc
+
+#include "check.h"
+
+#include "unordered_map.h"
+
+#include <stdlib.h>
+#include <unordered_map>
+
+// Every key hashes alike, so all of them share one probe run.
+struct colliding_key {
+  int v;
+};
+
+inline int operator==(const colliding_key& a, const colliding_key& b) {
+  return a.v == b.v;
+}
+
+inline unsigned hash_value(const colliding_key&) { return 12345u; }
+
+static colliding_key ckey(int v) {
+  colliding_key k;
+  k.v = v;
+  return k;
+}
+
+typedef unordered_map<int, int> int_map;
+
+// The contents against std::unordered_map, both by lookup and by iteration.
+static int same(int_map& m, std::unordered_map<int, int>& expect) {
+  if (m.size() != expect.size()) return 0;
+  for (std::unordered_map<int, int>::iterator e = expect.begin();
+       e != expect.end(); ++e) {
+    int_map::iterator it = m.find(e->first);
+    if (it == m.end() || it->second != e->second) return 0;
+  }
+  unsigned count = 0;
+  for (int_map::iterator it = m.begin(); it != m.end(); ++it) {
+    std::unordered_map<int, int>::iterator e = expect.find(it->first);
+    if (e == expect.end() || e->second != it->second) return 0;
+    count++;
+  }
+  return count == expect.size();
+}
+
+// Random inserts, overwrites, erases and lookups, with the key range
+// narrowing and widening so the table grows and runs get long.
+static void test_random() {
+  int_map m;
+  std::unordered_map<int, int> expect;
+  for (int round = 0; round < 20; round++) {
+    int range = round & 1 ? 50 : 5000;
+    for (int i = 0; i < 2000; i++) {
+      int k = rand() % range;
+      int v = rand();
+      switch (rand() % 4) {
+        case 0:
+          m.insert(k, v);
+          expect[k] = v;
+          break;
+        case 1:
+          CHECK(m.try_emplace(k, v).second == !expect.count(k));
+          expect.insert(std::make_pair(k, v));
+          break;
+        case 2:
+          m.erase(k);
+          expect.erase(k);
+          break;
+        default:
+          CHECK((m.find(k) != m.end()) == (int)expect.count(k));
+          break;
+      }
+    }
+    CHECK(same(m, expect));
+  }
+  m.clear();
+  CHECK(m.empty() && m.begin() == m.end());
+}
+
+// The value inserted is a reference into the table itself, both when the
+// insert rehashes and when it only shifts a run.
+static void test_aliased_insert() {
+  int_map m;
+  std::unordered_map<int, int> expect;
+  m.insert(0, 100);
+  expect[0] = 100;
+  for (int k = 1; k < 3000; k++) {
+    int from = rand() % k;
+    if (!expect.count(from)) from = 0;
+    m.insert(k, m.at(from));
+    expect[k] = expect[from];
+  }
+  CHECK(same(m, expect));
+
+  // Overwriting with a value from the same table.
+  for (int k = 0; k < 3000; k += 7) {
+    m.insert(k, m.at(k + 1));
+    expect[k] = expect[k + 1];
+  }
+  CHECK(same(m, expect));
+
+  // A key that refers into the table too.
+  unordered_map<int, int> keys;
+  keys.insert(1, 2);
+  for (int i = 0; i < 200; i++) {
+    keys.insert(keys.at(1) + i, 1);
+    CHECK(keys.find(2 + i) != keys.end());
+  }
+}
+
+static void test_colliding_hashes() {
+  unordered_map<colliding_key, int> m;
+  const int n = 600;
+  for (int i = 0; i < n; i++) CHECK(m.insert(ckey(i), i).second);
+  CHECK(m.size() == (unsigned)n);
+  for (int i = 0; i < n; i++) CHECK(m.at(ckey(i)) == i);
+  for (int i = 0; i < n; i += 2) m.erase(ckey(i));
+  CHECK(m.size() == (unsigned)n / 2);
+  for (int i = 0; i < n; i++)
+    CHECK((m.find(ckey(i)) != m.end()) == (i & 1));
+  for (int i = 0; i < n; i += 2) m.insert(ckey(i), m.at(ckey(i + 1)));
+  for (int i = 0; i < n; i += 2) CHECK(m.at(ckey(i)) == i + 1);
+}
+
+int main() {
+  test_random();
+  test_aliased_insert();
+  test_colliding_hashes();
+  return check_result();
+}
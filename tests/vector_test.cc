@@ -0,0 +1,127 @@
+// File: tests/vector_test.cc
+
+#include "check.h"
+
+#include "vector.h"
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Counts the capacity changes over n push_backs.
+static unsigned reallocations(vector<int>& v, unsigned n) {
+  unsigned count = 0;
+  for (unsigned i = 0; i < n; i++) {
+    unsigned cap = v.capacity();
+    v.push_back(i);
+    if (v.capacity() != cap) count++;
+    CHECK(v.capacity() >= v.size());
+  }
+  return count;
+}
+
+static unsigned log2_ceil(unsigned n) {
+  unsigned bits = 0;
+  while ((1u << bits) < n) bits++;
+  return bits;
+}
+
+static void test_geometric_growth() {
+  for (unsigned n = 1; n <= (1u << 20); n *= 4) {
+    vector<int> v;
+    unsigned count = reallocations(v, n);
+    // Doubling from 4 takes at most log2(n) - 1 steps after the first
+    // allocation.
+    CHECK(count <= log2_ceil(n) + 1);
+    CHECK(v.capacity() < 2 * n || v.capacity() == 4);
+    for (unsigned i = 0; i < n; i++)
+      if (v[i] != (int)i) {
+        CHECK(v[i] == (int)i);
+        break;
+      }
+  }
+}
+
+static void test_linear_growth() {
+  vector<int> v;
+  v.set_growth_policy(vector<int>::linear, 100);
+  unsigned count = reallocations(v, 10000);
+  CHECK(count == 100);
+  CHECK(v.capacity() - v.size() <= 100);
+}
+
+static void test_reserve_and_shrink() {
+  vector<int> v;
+  v.reserve(1000);
+  CHECK(v.capacity() == 1000);
+  CHECK(reallocations(v, 1000) == 0);
+  v.resize(10);
+  v.shrink_to_fit();
+  CHECK(v.capacity() == 10 && v.size() == 10);
+  v.push_back(1);
+  CHECK(v.capacity() == 20);
+}
+
+template <class T>
+static int same(vector<T>& v, const std::vector<T>& expect) {
+  if (v.size() != expect.size()) return 0;
+  for (unsigned i = 0; i < v.size(); i++)
+    if (!(v[i] == expect[i])) return 0;
+  return 1;
+}
+
+// Random range inserts from another vector and from the vector itself, with
+// and without spare capacity, against std::vector.
+template <class T>
+static void test_range_insert(T (*make)(int)) {
+  srand(1);
+  vector<T> v;
+  std::vector<T> expect;
+  for (int round = 0; round < 300; round++) {
+    vector<T> src;
+    for (int i = rand() % 8; i > 0; i--) src.push_back(make(rand()));
+    unsigned idx = rand() % (v.size() + 1);
+    if (round % 3 == 0) v.reserve(v.size() + src.size() + rand() % 4);
+    if (round % 5 == 4 && v.size()) {
+      unsigned first = rand() % v.size();
+      unsigned last = first + rand() % 8;
+      if (last > v.size()) last = v.size();
+      std::vector<T> copy(expect.begin() + first, expect.begin() + last);
+      expect.insert(expect.begin() + idx, copy.begin(), copy.end());
+      v.insert(v.begin() + idx, v.begin() + first, v.begin() + last);
+    } else {
+      expect.insert(expect.begin() + idx, src.data(),
+                    src.data() + src.size());
+      typename vector<T>::iterator it =
+          v.insert(v.begin() + idx, src.begin(), src.end());
+      CHECK(it == v.begin() + idx);
+    }
+    CHECK(same(v, expect));
+  }
+}
+
+static int make_int(int x) { return x; }
+
+static std::string make_string(int x) {
+  return std::string(x % 40, (char)('a' + x % 26));
+}
+
+static pair<int, int> make_int_pair(int x) { return make_pair(x, -x); }
+
+static void test_trivially_copyable() {
+  CHECK(is_trivially_copyable((const pair<int, int>*)0));
+  CHECK(is_trivially_copyable((const pair<char, pair<long, double> >*)0));
+  CHECK(!is_trivially_copyable((const pair<int, std::string>*)0));
+  CHECK(!is_trivially_copyable((const pair<std::string, int>*)0));
+}
+
+int main() {
+  test_range_insert(make_int);
+  test_range_insert(make_string);
+  test_range_insert(make_int_pair);
+  test_trivially_copyable();
+  test_geometric_growth();
+  test_linear_growth();
+  test_reserve_and_shrink();
+  return check_result();
+}
@@ -0,0 +1,154 @@
+// File: tests/work_stealing_deque_test.cc
+
+#include "check.h"
+
+#include "work_stealing_deque.h"
+
+#ifdef _REENTRANT
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static void test_single_thread() {
+  // Capacity 2, so the pushes below grow the ring several times.
+  work_stealing_deque<long> d(2);
+  long x;
+  CHECK(d.empty());
+  CHECK(!d.pop(x));
+  CHECK(!d.steal(x));
+
+  for (long i = 0; i < 100; i++) d.push(i);
+  CHECK(d.size() == 100);
+  // The owner takes the newest, a thief the oldest.
+  CHECK(d.pop(x) && x == 99);
+  CHECK(d.steal(x) && x == 0);
+  CHECK(d.steal(x) && x == 1);
+  for (long i = 98; i >= 2; i--) CHECK(d.pop(x) && x == i);
+  CHECK(!d.pop(x));
+  CHECK(!d.steal(x));
+  CHECK(d.empty());
+
+  // Still usable after being emptied from both ends.
+  d.push(7);
+  CHECK(d.steal(x) && x == 7);
+  d.push(8);
+  CHECK(d.pop(x) && x == 8);
+  CHECK(d.empty());
+}
+
+#ifdef _REENTRANT
+
+static const int kThieves = 3;
+static const long kTasks = 200000;
+
+static work_stealing_deque<long>* deque;
+static volatile int owner_done;
+// runs[t][i] counts how often thread t took task i; thread 0 is the owner.
+static unsigned char runs[kThieves + 1][kTasks];
+
+static void* thief(void* arg) {
+  unsigned char* mine = runs[(long)arg];
+  long x;
+  for (;;) {
+    int done = atomic_load_acquire(&owner_done);
+    if (deque->steal(x)) {
+      mine[x]++;
+    } else if (done && deque->empty()) {
+      return 0;
+    } else {
+      sched_yield();
+    }
+  }
+}
+
+// The owner pushes every task, popping one back after every third push so
+// that pops race the thieves throughout, then drains whatever is left.
+static void test_owner_and_thieves() {
+  work_stealing_deque<long> d(2);
+  deque = &d;
+  pthread_t threads[kThieves];
+  for (long t = 0; t < kThieves; t++)
+    pthread_create(&threads[t], 0, thief, (void*)(t + 1));
+
+  long x;
+  for (long i = 0; i < kTasks; i++) {
+    d.push(i);
+    if (i % 3 == 2 && d.pop(x)) runs[0][x]++;
+  }
+  while (!d.empty())
+    if (d.pop(x)) runs[0][x]++;
+  atomic_store_release(&owner_done, 1);
+  for (int t = 0; t < kThieves; t++) pthread_join(threads[t], 0);
+
+  long wrong = 0;
+  for (long i = 0; i < kTasks; i++) {
+    int n = 0;
+    for (int t = 0; t <= kThieves; t++) n += runs[t][i];
+    if (n != 1) wrong++;
+  }
+  CHECK(!wrong);
+  CHECK(d.empty());
+}
+
+// Task i spawns tasks 2i+1 and 2i+2, so the whole tree starts from task 0
+// on worker 0 and spreads to the others only by stealing.
+static const int kTreeTasks = 65535;
+static volatile long tree_runs[kTreeTasks];
+
+class tree_task : public ws_task {
+ public:
+  int id;
+
+  void run(work_stealing_scheduler& sched, int worker);
+};
+
+static tree_task tree[kTreeTasks];
+
+void tree_task::run(work_stealing_scheduler& sched, int worker) {
+  atomic_fetch_add(&tree_runs[id], 1L);
+  for (int c = 2 * id + 1; c <= 2 * id + 2 && c < kTreeTasks; c++)
+    sched.spawn(worker, &tree[c]);
+}
+
+struct worker_arg {
+  work_stealing_scheduler* sched;
+  int self;
+};
+
+static void* worker_main(void* arg) {
+  worker_arg* w = (worker_arg*)arg;
+  w->sched->run_worker(w->self);
+  return 0;
+}
+
+static void test_scheduler() {
+  const int kWorkers = 4;
+  work_stealing_scheduler sched(kWorkers);
+  for (int i = 0; i < kTreeTasks; i++) tree[i].id = i;
+  sched.spawn(0, &tree[0]);
+
+  pthread_t threads[kWorkers];
+  worker_arg args[kWorkers];
+  for (int w = 0; w < kWorkers; w++) {
+    args[w].sched = &sched;
+    args[w].self = w;
+    pthread_create(&threads[w], 0, worker_main, &args[w]);
+  }
+  for (int w = 0; w < kWorkers; w++) pthread_join(threads[w], 0);
+
+  long wrong = 0;
+  for (int i = 0; i < kTreeTasks; i++)
+    if (tree_runs[i] != 1) wrong++;
+  CHECK(!wrong);
+}
+
+#endif  // _REENTRANT
+
+int main() {
+  test_single_thread();
+#ifdef _REENTRANT
+  test_owner_and_thieves();
+  test_scheduler();
+#endif
+  return check_result();
+}
@@ -0,0 +1,299 @@
+// File: unordered_map.h
+//
+// Description: Hash map with open addressing and Robin Hood linear probing.
+//              Keys and values live in one flat slot array and a parallel
+//              array of probe distances marks the free slots. Runs
+//              stay ordered by home slot, so a lookup stops at the first slot
+//              that is closer to its own home than the key would be, and an
+//              erase shifts the rest of the run back instead of leaving a
+//              tombstone. Keys need operator== and a hash_value overload, see
+//              hash.h.
+
+#ifndef _STL_UNORDERED_MAP_H_
+#define _STL_UNORDERED_MAP_H_
+
+#include "hash.h"
+#include "utility.h"
+
+#include <assert.h>
+
+template <class Key, class Value>
+class unordered_map {
+ public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef pair<Key, Value> value_type;
+  typedef unsigned size_type;
+
+  unordered_map()
+      : slots_(0),
+        dist_(0),
+        cap_(0u),
+        bits_(0u),
+        size_(0u),
+        grow_at_(0u),
+        max_load_(0.875f) {}
+
+  unordered_map(const unordered_map& cp)
+      : slots_(0),
+        dist_(0),
+        cap_(0u),
+        bits_(0u),
+        size_(0u),
+        grow_at_(0u),
+        max_load_(cp.max_load_) {
+    copy(cp);
+  }
+
+  ~unordered_map() { release(); }
+
+  unordered_map& operator=(const unordered_map& cp) {
+    if (this != &cp) {
+      release();
+      max_load_ = cp.max_load_;
+      copy(cp);
+    }
+    return *this;
+  }
+
+  void clear() {
+    for (size_type i = 0; i < cap_; i++) {
+      if (dist_[i]) _destroy(slots_ + i);
+      dist_[i] = 0;
+    }
+    size_ = 0;
+  }
+
+  size_type size() const { return size_; }
+  int empty() const { return !size_; }
+  size_type bucket_count() const { return cap_; }
+
+  float load_factor() const { return cap_ ? (float)size_ / cap_ : 0.0f; }
+  float max_load_factor() const { return max_load_; }
+
+  // Robin Hood probing keeps probes short up to about 0.9.
+  void max_load_factor(float mlf) {
+    assert(mlf > 0.0f && mlf < 1.0f);
+    max_load_ = mlf;
+    grow_at_ = (size_type)(cap_ * max_load_);
+    if (size_ >= grow_at_ && cap_) rehash(cap_ + cap_);
+  }
+
+  // Makes room for n elements without rehashing.
+  void reserve(size_type n) {
+    size_type cap = cap_ ? cap_ : 8u;
+    while ((size_type)(cap * max_load_) <= n) cap += cap;
+    if (cap > cap_) rehash(cap);
+  }
+
+  mapped_type& at(const key_type& key) {
+    size_type idx = find_idx(key);
+    assert(idx != cap_);
+    return slots_[idx].second;
+  }
+
+  const mapped_type& at(const key_type& key) const {
+    size_type idx = find_idx(key);
+    assert(idx != cap_);
+    return slots_[idx].second;
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+
+  void erase(const key_type& key) {
+    size_type idx = find_idx(key);
+    if (idx == cap_) return;
+    // Shift the rest of the run back by one slot.
+    size_type next = (idx + 1) & (cap_ - 1);
+    while (dist_[next] > 1) {
+      slots_[idx] = slots_[next];
+      dist_[idx] = dist_[next] - 1;
+      idx = next;
+      next = (next + 1) & (cap_ - 1);
+    }
+    _destroy(slots_ + idx);
+    dist_[idx] = 0;
+    size_--;
+  }
+
+ private:
+  // dist_[i] is the probe distance of slot i plus one, or 0 if it is free.
+  // A word rather than a byte: no run is longer than the table, so even keys
+  // whose hashes all collide always find a slot.
+  value_type* slots_;
+  size_type* dist_;
+  size_type cap_, bits_, size_, grow_at_;
+  float max_load_;
+
+  size_type home(const key_type& key) const {
+    return _hash_index(hash_value(key), bits_);
+  }
+
+  size_type find_idx(const key_type& key) const {
+    if (!size_) return cap_;
+    size_type idx = home(key);
+    for (unsigned d = 1; dist_[idx] >= d; d++) {
+      if (dist_[idx] == d && slots_[idx].first == key) return idx;
+      idx = (idx + 1) & (cap_ - 1);
+    }
+    return cap_;
+  }
+
+  // Makes slot idx free for an element at probe distance d by shifting the
+  // run that starts there one slot further. There is a free slot somewhere,
+  // since the table is never full.
+  void open_slot(size_type idx, size_type d) {
+    size_type end = idx;
+    while (dist_[end]) end = (end + 1) & (cap_ - 1);
+    while (end != idx) {
+      size_type prev = (end - 1) & (cap_ - 1);
+      if (dist_[end])
+        slots_[end] = slots_[prev];
+      else
+        _construct(slots_ + end, slots_[prev]);
+      dist_[end] = dist_[prev] + 1;
+      end = prev;
+    }
+    if (dist_[idx]) _destroy(slots_ + idx);
+    dist_[idx] = d;
+  }
+
+  // Links an element whose key is absent and returns its slot. item must not
+  // live in slots_, which this shifts.
+  size_type place(const value_type& item) {
+    size_type idx = home(item.first);
+    size_type d = 1;
+    while (dist_[idx] >= d) {
+      idx = (idx + 1) & (cap_ - 1);
+      d++;
+    }
+    open_slot(idx, d);
+    _construct(slots_ + idx, item);
+    size_++;
+    return idx;
+  }
+
+  void rehash(size_type cap) {
+    value_type* old_slots = slots_;
+    size_type* old_dist = dist_;
+    size_type old_cap = cap_;
+
+    slots_ = _allocate(cap, (value_type*)0);
+    dist_ = new size_type[cap];
+    for (size_type i = 0; i < cap; i++) dist_[i] = 0;
+    cap_ = cap;
+    for (bits_ = 0; (1u << bits_) < cap; bits_++) {
+    }
+    grow_at_ = (size_type)(cap_ * max_load_);
+    size_ = 0;
+
+    for (size_type j = 0; j < old_cap; j++) {
+      if (!old_dist[j]) continue;
+      place(old_slots[j]);
+      _destroy(old_slots + j);
+    }
+    _deallocate(old_slots);
+    delete[] old_dist;
+  }
+
+  void release() {
+    clear();
+    _deallocate(slots_);
+    delete[] dist_;
+    slots_ = 0;
+    dist_ = 0;
+    cap_ = bits_ = grow_at_ = 0;
+  }
+
+  void copy(const unordered_map& cp) {
+    if (!cp.cap_) return;
+    slots_ = _allocate(cp.cap_, (value_type*)0);
+    dist_ = new size_type[cp.cap_];
+    cap_ = cp.cap_;
+    bits_ = cp.bits_;
+    grow_at_ = cp.grow_at_;
+    for (size_type i = 0; i < cap_; i++) {
+      dist_[i] = cp.dist_[i];
+      if (dist_[i]) _construct(slots_ + i, cp.slots_[i]);
+    }
+    size_ = cp.size_;
+  }
+
+ public:
+  class iterator {
+   public:
+    iterator() : owner_(0), idx_(0) {}
+
+    void operator++() { idx_ = owner_->next_used(idx_ + 1); }
+
+    void operator++(int k) { idx_ = owner_->next_used(idx_ + 1); }
+
+    value_type& operator*() {
+      assert(idx_ < owner_->cap_);
+      return owner_->slots_[idx_];
+    }
+
+    value_type* operator->() {
+      assert(idx_ < owner_->cap_);
+      return owner_->slots_ + idx_;
+    }
+
+    int operator==(const iterator& rhs) const {
+      if (!owner_) return 0;
+      if (owner_ != rhs.owner_) return 0;
+      return idx_ == rhs.idx_;
+    }
+
+    int operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+   private:
+    unordered_map<key_type, mapped_type>* owner_;
+    size_type idx_;
+
+    iterator(unordered_map<key_type, mapped_type>* owner, size_type idx)
+        : owner_(owner), idx_(idx) {}
+
+    friend class unordered_map<key_type, mapped_type>;
+  };
+
+  iterator begin() { return iterator(this, next_used(0)); }
+
+  iterator end() { return iterator(this, cap_); }
+
+  iterator find(const key_type& key) { return iterator(this, find_idx(key)); }
+
+  // Inserts key with a default value unless it is already there; .second is
+  // nonzero if the key was inserted.
+  pair<iterator, int> try_emplace(const key_type& key) {
+    return try_emplace(key, mapped_type());
+  }
+
+  pair<iterator, int> try_emplace(const key_type& key, const mapped_type& val) {
+    size_type idx = find_idx(key);
+    if (idx != cap_) return make_pair(iterator(this, idx), 0);
+    // key and val may refer into slots_ (m.insert(k, m.at(j))), which the
+    // rehash frees and place() shifts, so they are copied out first.
+    value_type item(key, val);
+    if (size_ + 1 > grow_at_) rehash(cap_ ? cap_ + cap_ : 8u);
+    idx = place(item);
+    return make_pair(iterator(this, idx), 1);
+  }
+
+  // Inserts key or overwrites its value; .second is nonzero if the key was
+  // inserted.
+  pair<iterator, int> insert(const key_type& key, const mapped_type& val) {
+    pair<iterator, int> res = try_emplace(key, val);
+    if (!res.second) res.first->second = val;
+    return res;
+  }
+
+ private:
+  size_type next_used(size_type idx) const {
+    while (idx < cap_ && !dist_[idx]) idx++;
+    return idx;
+  }
+};
+
+#endif  // _STL_UNORDERED_MAP_H_
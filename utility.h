@@ -5,6 +5,14 @@
 #ifndef _STL_UTILITY_H_
 #define _STL_UTILITY_H_
 
+#ifdef __BORLANDC__
+#include <new.h>
+#else
+#include <new>
+#endif
+
+#include <string.h>
+
 template <class T1, class T2>
 struct pair {
   typedef T1 first_type;
@@ -53,4 +61,175 @@ pair<T1, T2> make_pair(T1 x, T2 y) {
   return pair<T1, T2>(x, y);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//  Three-way comparison:
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns a negative value, zero or a positive value as lhs orders before,
+// equal to or after rhs. Ordered containers branch on a single call per node
+// instead of asking == and < in turn. The default costs up to two operator<
+// calls; key types that can order in one pass (strings, composite keys)
+// should overload it, e.g.
+//   inline int compare(const name& lhs, const name& rhs) {
+//     return strcmp(lhs.str, rhs.str);
+//   }
+template <class T>
+int compare(const T& lhs, const T& rhs) {
+  if (lhs < rhs) return -1;
+  return rhs < lhs;
+}
+
+// For the builtin types == is tested first, which compilers turn into a
+// branch-free choice of child in ordered lookups.
+inline int compare(char a, char b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(signed char a, signed char b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(unsigned char a, unsigned char b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(short a, short b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(unsigned short a, unsigned short b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(int a, int b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(unsigned a, unsigned b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(long a, long b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(unsigned long a, unsigned long b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(float a, float b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(double a, double b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+inline int compare(long double a, long double b) {
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+
+template <class T1, class T2>
+int compare(const pair<T1, T2>& lhs, const pair<T1, T2>& rhs) {
+  int c = compare(lhs.first, rhs.first);
+  return c ? c : compare(lhs.second, rhs.second);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Type traits:
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns nonzero if objects of type T can be copied with memcpy and need no
+// destructor call. Containers use it to copy and shift elements in bulk.
+// BCC has no partial specialization, so the trait is an overload set picked by
+// a (never dereferenced) pointer; POD types opt in with an overload such as
+//   inline int is_trivially_copyable(const point*) { return 1; }
+template <class T>
+int is_trivially_copyable(const T*) {
+  return 0;
+}
+
+inline int is_trivially_copyable(const char*) { return 1; }
+inline int is_trivially_copyable(const signed char*) { return 1; }
+inline int is_trivially_copyable(const unsigned char*) { return 1; }
+inline int is_trivially_copyable(const short*) { return 1; }
+inline int is_trivially_copyable(const unsigned short*) { return 1; }
+inline int is_trivially_copyable(const int*) { return 1; }
+inline int is_trivially_copyable(const unsigned*) { return 1; }
+inline int is_trivially_copyable(const long*) { return 1; }
+inline int is_trivially_copyable(const unsigned long*) { return 1; }
+inline int is_trivially_copyable(const float*) { return 1; }
+inline int is_trivially_copyable(const double*) { return 1; }
+inline int is_trivially_copyable(const long double*) { return 1; }
+
+// A pair is trivially copyable when both of its members are.
+template <class T1, class T2>
+int is_trivially_copyable(const pair<T1, T2>*) {
+  return is_trivially_copyable((const T1*)0) &&
+         is_trivially_copyable((const T2*)0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Raw storage helpers:
+////////////////////////////////////////////////////////////////////////////////
+
+// Containers that keep spare capacity allocate raw memory and construct only
+// the live elements, so T doesn't have to be default constructible. BCC can't
+// take explicit template arguments, so _allocate gets T from a null pointer.
+template <class T>
+T* _allocate(unsigned n, T*) {
+  return n ? (T*)::operator new(n * sizeof(T)) : 0;
+}
+
+template <class T>
+void _deallocate(T* p) {
+  ::operator delete((void*)p);
+}
+
+template <class T>
+void _construct(T* p) {
+  new ((void*)p) T();
+}
+
+template <class T>
+void _construct(T* p, const T& val) {
+  new ((void*)p) T(val);
+}
+
+template <class T>
+void _destroy(T* p) {
+  p->~T();
+}
+
+// Inserts val at pos into the n live elements of the raw array a, which has
+// room for one more. val mustn't be one of the elements.
+template <class T>
+void _raw_insert(T* a, unsigned n, unsigned pos, const T& val) {
+  if (is_trivially_copyable(a)) {
+    memmove((void*)(a + pos + 1), (const void*)(a + pos),
+            (n - pos) * sizeof(T));
+    _construct(a + pos, val);
+  } else if (pos == n) {
+    _construct(a + n, val);
+  } else {
+    _construct(a + n, a[n - 1]);
+    for (unsigned i = n - 1; i > pos; i--) a[i] = a[i - 1];
+    a[pos] = val;
+  }
+}
+
+// Removes the element at pos from the n live elements of the raw array a.
+template <class T>
+void _raw_erase(T* a, unsigned n, unsigned pos) {
+  if (is_trivially_copyable(a)) {
+    memmove((void*)(a + pos), (const void*)(a + pos + 1),
+            (n - pos - 1) * sizeof(T));
+    return;
+  }
+  for (unsigned i = pos + 1; i < n; i++) a[i - 1] = a[i];
+  _destroy(a + n - 1);
+}
+
+// Moves n elements from src to the raw storage at dst, leaving src raw.
+template <class T>
+void _raw_move(T* dst, T* src, unsigned n) {
+  if (is_trivially_copyable(dst)) {
+    memcpy((void*)dst, (const void*)src, n * sizeof(T));
+    return;
+  }
+  for (unsigned i = 0; i < n; i++) {
+    _construct(dst + i, src[i]);
+    _destroy(src + i);
+  }
+}
+
 #endif  // _STL_UTILITY_H_
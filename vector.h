@@ -2,8 +2,12 @@
 #define _STL_VECTOR_H_
 
 #include "algo.h"
+#include "allocator.h"
+#include "instrument.h"
+#include "utility.h"
 
 #include <assert.h>
+#include <string.h>
 
 template <class T>
 class vector {
@@ -11,28 +15,78 @@ class vector {
   typedef T value_type;
   typedef unsigned size_type;
 
-  vector(size_type size = 0)
-      : size_(size), cap_(max(32u, size_)), v_(new value_type[cap_]) {}
+  // How the capacity grows when push_back or resize outgrow it. Geometric
+  // growth doubles the capacity, so n push_backs cost O(log n) reallocations.
+  // Linear growth adds a fixed step and trades reallocations for memory.
+  enum growth_policy { geometric, linear };
+
+  // Nothing is allocated until the first element arrives.
+  vector()
+      : alloc_(0),
+        size_(0),
+        cap_(0),
+        policy_(geometric),
+        step_(32u),
+        v_(0),
+        inline_(0) {}
+
+  // Allocates through alloc, see allocator.h.
+  vector(allocator& alloc)
+      : alloc_(&alloc),
+        size_(0),
+        cap_(0),
+        policy_(geometric),
+        step_(32u),
+        v_(0),
+        inline_(0) {}
+
+  vector(size_type size)
+      : alloc_(0),
+        size_(size),
+        cap_(size),
+        policy_(geometric),
+        step_(32u),
+        v_(allocate(cap_)),
+        inline_(0) {
+    for (size_type i = 0; i < size_; i++) _construct(v_ + i);
+  }
 
   vector(size_type size, const value_type& val)
-      : size_(size), cap_(max(32u, size_)), v_(new value_type[cap_]) {
-    for (size_type i = 0; i < size_; i++) v_[i] = val;
+      : alloc_(0),
+        size_(size),
+        cap_(size),
+        policy_(geometric),
+        step_(32u),
+        v_(allocate(cap_)),
+        inline_(0) {
+    for (size_type i = 0; i < size_; i++) _construct(v_ + i, val);
   }
 
+  // The copy allocates like cp; assignment keeps the target's allocator.
   vector(const vector& cp)
-      : size_(cp.size_), cap_(cp.cap_), v_(new value_type[cap_]) {
-    for (size_type i = 0; i < size_; i++) v_[i] = cp.v_[i];
+      : alloc_(cp.alloc_),
+        size_(cp.size_),
+        cap_(cp.size_),
+        policy_(cp.policy_),
+        step_(cp.step_),
+        v_(allocate(cap_)),
+        inline_(0) {
+    copy_construct(v_, cp.v_, size_);
   }
 
-  ~vector() { delete[] v_; }
+  ~vector() {
+    clear();
+    release();
+  }
 
   vector& operator=(const vector& cp) {
     if (this != &cp) {
-      delete[] v_;
-      cap_ = cp.cap_;
+      clear();
+      policy_ = cp.policy_;
+      step_ = cp.step_;
+      reserve(cp.size_);
+      copy_construct(v_, cp.v_, cp.size_);
       size_ = cp.size_;
-      v_ = new value_type[cap_];
-      for (size_type i = 0; i < size_; i++) v_[i] = cp.v_[i];
     }
     return *this;
   }
@@ -47,49 +101,124 @@ class vector {
     return v_[idx];
   }
 
+  value_type& front() {
+    assert(size_);
+    return v_[0];
+  }
+
+  const value_type& front() const {
+    assert(size_);
+    return v_[0];
+  }
+
+  value_type& back() {
+    assert(size_);
+    return v_[size_ - 1];
+  }
+
+  const value_type& back() const {
+    assert(size_);
+    return v_[size_ - 1];
+  }
+
   size_type size() const { return size_; }
   size_type capacity() const { return cap_; }
   int empty() const { return !size_; }
 
-  void clear() { resize(0); }
+  // The elements as a plain array, for unchecked loops and the raw pointer
+  // overloads in algo.h. Null while nothing has been allocated.
+  value_type* data() { return v_; }
+  const value_type* data() const { return v_; }
+
+  growth_policy policy() const { return policy_; }
+
+  // Null when the vector uses global new and delete.
+  allocator* get_allocator() const { return alloc_; }
+
+#ifdef STL_INSTRUMENT
+  // The counters of this vector since it was constructed, see instrument.h.
+  container_stats stats() const { return stats_; }
+#endif
+
+  // The step is only used by the linear policy and must be positive.
+  void set_growth_policy(growth_policy policy, size_type step = 32u) {
+    assert(step);
+    policy_ = policy;
+    step_ = step;
+  }
+
+  void clear() { destroy_tail(0); }
+
+  int operator==(const vector& rhs) const {
+    if (size_ != rhs.size_) return 0;
+    for (size_type i = 0; i < size_; i++)
+      if (v_[i] != rhs.v_[i]) return 0;
+    return 1;
+  }
+
+  int operator!=(const vector& rhs) const { return !(*this == rhs); }
 
   void resize(size_type size) {
-    if (size_ == size) return;
-    if (size < size_)
-      size_ = size;
-    else {
-      if (size > cap_) reserve(new_capacity(size));
-      size_ = size;
-    }
+    if (size < size_) destroy_tail(size);
+    if (size > cap_) reserve(new_capacity(size));
+    for (; size_ < size; size_++) _construct(v_ + size_);
   }
 
   void resize(size_type size, const value_type& val) {
-    size_type old_size = size_;
-    resize(size);
-    for (int i = old_size; i < size_; i++) v_[i] = val;
+    if (size < size_) destroy_tail(size);
+    if (size > cap_) {
+      // val may live in the old buffer, so construct before releasing it.
+      size_type cap = new_capacity(size);
+      value_type* temp = allocate(cap);
+      for (size_type i = size_; i < size; i++) _construct(temp + i, val);
+      adopt(temp, cap);
+    } else {
+      for (size_type i = size_; i < size; i++) _construct(v_ + i, val);
+    }
+    size_ = size;
   }
 
   void reserve(size_type cap) {
     if (cap <= cap_) return;
-    value_type* temp = new value_type[cap];
-    for (size_type i = 0; i < size_; i++) temp[i] = v_[i];
-    delete[] v_;
-    v_ = temp;
+    adopt(allocate(cap), cap);
+  }
+
+  // A vector living in its inline buffer (see small_vector) stays there.
+  void shrink_to_fit() {
+    if (v_ == inline_) return;
+    if (size_ < cap_) adopt(allocate(size_), size_);
   }
 
   void push_back(const value_type& val) {
-    resize(size_ + 1);
-    v_[size_ - 1] = val;
+    if (size_ == cap_) {
+      // val may live in the old buffer, so construct before releasing it.
+      size_type cap = new_capacity(size_ + 1);
+      value_type* temp = allocate(cap);
+      _construct(temp + size_, val);
+      adopt(temp, cap);
+    } else {
+      _construct(v_ + size_, val);
+    }
+    size_++;
+  }
+
+  // Default-constructs the new element in place. BCC has no member templates,
+  // so arguments can't be forwarded; fill the returned element instead.
+  value_type& emplace_back() {
+    if (size_ == cap_) reserve(new_capacity(size_ + 1));
+    _construct(v_ + size_);
+    return v_[size_++];
   }
 
   void pop_back() {
     assert(size_);
-    size_--;
+    _destroy(v_ + --size_);
   }
 
   class iterator {
    public:
     value_type& operator*() { return *ptr_; }
+    value_type* operator->() { return ptr_; }
     value_type& operator[](int n) { return *(ptr_ + n); }
 
     int operator==(const iterator& rhs) {
@@ -146,7 +275,7 @@ class vector {
     value_type* ptr_;
     vector<value_type>* owner_;
     iterator(vector<value_type>* owner, value_type* ptr)
-        : owner_(owner), ptr_(ptr) {}
+        : ptr_(ptr), owner_(owner) {}
 
     friend class vector<value_type>;
   };
@@ -154,14 +283,223 @@ class vector {
   iterator begin() { return iterator(this, v_); }
   iterator end() { return iterator(this, v_ + size_); }
 
+  iterator insert(iterator pos, const value_type& val) {
+    size_type idx = pos.ptr_ - v_;
+    assert(idx <= size_);
+    if (size_ == cap_) {
+      size_type cap = new_capacity(size_ + 1);
+      value_type* temp = allocate(cap);
+      _construct(temp + idx, val);
+      adopt(temp, cap, idx);
+    } else if (idx == size_) {
+      _construct(v_ + idx, val);
+    } else {
+      // Shifting moves val along with the tail when it aliases an element.
+      const value_type* pval = &val;
+      if (v_ + idx <= pval && pval < v_ + size_) pval++;
+      open_gap(idx);
+      v_[idx] = *pval;
+    }
+    size_++;
+    return iterator(this, v_ + idx);
+  }
+
+  // Inserts copies of [first, last) before pos and returns an iterator to the
+  // first of them. BCC has no member templates, so the range is given as
+  // pointers (such as another vector's data()) or as vector iterators.
+  iterator insert(iterator pos, const value_type* first,
+                  const value_type* last) {
+    size_type idx = pos.ptr_ - v_;
+    size_type n = last - first;
+    assert(idx <= size_ && first <= last);
+    if (!n) return iterator(this, v_ + idx);
+    if (v_ <= first && first < v_ + size_) {
+      // The range would move while the tail shifts, so insert a copy of it.
+      vector<value_type> temp;
+      temp.reserve(n);
+      temp.copy_construct(temp.v_, first, n);
+      temp.size_ = n;
+      return insert(pos, temp.v_, temp.v_ + n);
+    }
+    if (size_ + n > cap_) {
+      size_type cap = new_capacity(size_ + n);
+      value_type* temp = allocate(cap);
+      copy_construct(temp + idx, first, n);
+      adopt(temp, cap, idx, n);
+    } else if (is_trivially_copyable(v_)) {
+      memmove((void*)(v_ + idx + n), (const void*)(v_ + idx),
+              (size_ - idx) * sizeof(value_type));
+      memcpy((void*)(v_ + idx), (const void*)first, n * sizeof(value_type));
+    } else {
+      // Slots at or past size_ are raw and are constructed, the rest are
+      // assigned.
+      for (size_type i = size_ + n; i-- > idx + n;) {
+        if (i >= size_)
+          _construct(v_ + i, v_[i - n]);
+        else
+          v_[i] = v_[i - n];
+      }
+      for (size_type i = 0; i < n; i++) {
+        if (idx + i < size_)
+          v_[idx + i] = first[i];
+        else
+          _construct(v_ + idx + i, first[i]);
+      }
+    }
+    size_ += n;
+    return iterator(this, v_ + idx);
+  }
+
+  iterator insert(iterator pos, iterator first, iterator last) {
+    return insert(pos, (const value_type*)first.ptr_,
+                  (const value_type*)last.ptr_);
+  }
+
+  // Inserts a default-constructed element before pos, see emplace_back().
+  iterator emplace(iterator pos) {
+    size_type idx = pos.ptr_ - v_;
+    assert(idx <= size_);
+    if (size_ == cap_) {
+      size_type cap = new_capacity(size_ + 1);
+      value_type* temp = allocate(cap);
+      _construct(temp + idx);
+      adopt(temp, cap, idx);
+    } else if (idx == size_) {
+      _construct(v_ + idx);
+    } else {
+      open_gap(idx);
+      _destroy(v_ + idx);
+      _construct(v_ + idx);
+    }
+    size_++;
+    return iterator(this, v_ + idx);
+  }
+
+  iterator erase(iterator pos) { return erase(pos, pos + 1); }
+
+  iterator erase(iterator first, iterator last) {
+    size_type idx = first.ptr_ - v_;
+    size_type n = last.ptr_ - first.ptr_;
+    assert(idx + n <= size_);
+    if (!n) return first;
+    if (is_trivially_copyable(v_))
+      memmove((void*)(v_ + idx), (const void*)(v_ + idx + n),
+              (size_ - idx - n) * sizeof(value_type));
+    else
+      for (size_type i = idx + n; i < size_; i++) v_[i - n] = v_[i];
+    destroy_tail(size_ - n);
+    return iterator(this, v_ + idx);
+  }
+
+ protected:
+  // Starts out in caller-provided raw storage for cap elements, which is never
+  // freed and is only left once the elements outgrow it.
+  vector(value_type* buf, size_type cap)
+      : alloc_(0),
+        size_(0),
+        cap_(cap),
+        policy_(geometric),
+        step_(32u),
+        v_(buf),
+        inline_(buf) {}
+
+  // Moves the elements back into that storage, of cap elements, if they left
+  // it and fit there again.
+  void return_inline(size_type cap) {
+    if (v_ != inline_ && size_ <= cap) adopt(inline_, cap);
+  }
+
  private:
+#ifdef STL_INSTRUMENT
+  // Declared first, so that it is constructed before the allocations made
+  // in the member initializers are counted.
+  container_stats stats_;
+#endif
+  // Declared before v_: the member initializers allocate through it.
+  allocator* alloc_;
   size_type size_, cap_;
+  growth_policy policy_;
+  size_type step_;
   value_type* v_;
+  value_type* inline_;
 
   size_type new_capacity(size_type new_size) {
-    return (new_size / 32u + 1) * 32u;
-    //    size_type delta = new_size - cap_ - (cap_ - cap_ / 32u);
-    //    return delta / 32u + ((delta % 32u) ? 0 : 1);
+    if (policy_ == linear) return (new_size / step_ + 1) * step_;
+    size_type cap = cap_ ? cap_ : 4u;
+    while (cap < new_size) {
+      // Doubling would overflow size_type, so settle for the exact size.
+      if (cap + cap < cap) return new_size;
+      cap += cap;
+    }
+    return cap;
+  }
+
+  value_type* allocate(size_type n) {
+    if (n) {
+      _STL_COUNT(stats_, stats_vector, allocs, 1);
+      _STL_COUNT(stats_, stats_vector, bytes, n * sizeof(value_type));
+    }
+    return (value_type*)_allocate_bytes(alloc_, n * sizeof(value_type));
+  }
+
+  // Copies the live elements into temp, which has room for cap elements, and
+  // releases the old buffer. Elements at or after gap shift up by gap_size
+  // slots.
+  void adopt(value_type* temp, size_type cap, size_type gap = (size_type)-1,
+             size_type gap_size = 1) {
+    if (v_) _STL_COUNT(stats_, stats_vector, reallocs, 1);
+    _STL_COUNT(stats_, stats_vector, copies, size_);
+    if (!size_) {
+      // Nothing to move, and v_ may still be null.
+    } else if (is_trivially_copyable(v_)) {
+      if (gap > size_) gap = size_;
+      memcpy((void*)temp, (const void*)v_, gap * sizeof(value_type));
+      memcpy((void*)(temp + gap + gap_size), (const void*)(v_ + gap),
+             (size_ - gap) * sizeof(value_type));
+    } else {
+      for (size_type i = 0; i < size_; i++) {
+        _construct(temp + i + (i >= gap ? gap_size : 0), v_[i]);
+        _destroy(v_ + i);
+      }
+    }
+    release();
+    v_ = temp;
+    cap_ = cap;
+  }
+
+  // Shifts [idx, size_) up by one slot, leaving v_[idx] as a stale copy.
+  void open_gap(size_type idx) {
+    if (is_trivially_copyable(v_)) {
+      memmove((void*)(v_ + idx + 1), (const void*)(v_ + idx),
+              (size_ - idx) * sizeof(value_type));
+      return;
+    }
+    _construct(v_ + size_, v_[size_ - 1]);
+    for (size_type i = size_ - 1; i > idx; i--) v_[i] = v_[i - 1];
+  }
+
+  // Copy-constructs n elements from src into the raw storage at dst.
+  void copy_construct(value_type* dst, const value_type* src, size_type n) {
+    if (!n) return;
+    _STL_COUNT(stats_, stats_vector, copies, n);
+    if (is_trivially_copyable(dst))
+      memcpy((void*)dst, (const void*)src, n * sizeof(value_type));
+    else
+      for (size_type i = 0; i < n; i++) _construct(dst + i, src[i]);
+  }
+
+  void release() {
+    if (v_ == inline_) return;
+    if (v_) _STL_COUNT(stats_, stats_vector, frees, 1);
+    _deallocate_bytes(alloc_, v_, cap_ * sizeof(value_type));
+  }
+
+  // Destroys the elements at and after size and makes size the new size.
+  void destroy_tail(size_type size) {
+    if (is_trivially_copyable(v_))
+      size_ = size;
+    else
+      while (size_ > size) _destroy(v_ + --size_);
   }
 };
 
@@ -0,0 +1,199 @@
+// File: work_stealing_deque.h
+//
+// Description: Chase-Lev work-stealing deque and a reference scheduler loop
+//              with one deque per worker. The owner pushes and pops at the
+//              bottom without contention; idle workers steal from the top.
+//              Info: Le et al., "Correct and Efficient Work-Stealing for Weak
+//              Memory Models", PPoPP 2013.
+
+#ifndef _STL_WORK_STEALING_DEQUE_H_
+#define _STL_WORK_STEALING_DEQUE_H_
+
+#include "atomic.h"
+#include "utility.h"
+
+#include <assert.h>
+
+// T must be a pointer or an integer: thieves read slots that the owner may be
+// overwriting, so every slot access is atomic. push() and pop() belong to one
+// owner thread, steal() may be called from any thread.
+template <class T>
+class work_stealing_deque {
+ public:
+  typedef T value_type;
+
+  work_stealing_deque(long capacity = 64) : top_(0), bottom_(0), ring_(0) {
+    long cap = 1;
+    while (cap < capacity) cap *= 2;
+    ring_ = new_ring(cap, 0);
+  }
+
+  // No other thread may be using the deque any more.
+  ~work_stealing_deque() {
+    for (ring* r = ring_; r;) {
+      ring* retired = r->retired;
+      _deallocate(r->slots);
+      delete r;
+      r = retired;
+    }
+  }
+
+  // A snapshot, possibly stale by the time it returns.
+  long size() const {
+    long n = atomic_load_acquire(&bottom_) - atomic_load_acquire(&top_);
+    return n > 0 ? n : 0;
+  }
+
+  int empty() const { return !size(); }
+
+  // Owner only. Doubles the buffer when it is full.
+  void push(value_type val) {
+    long b = atomic_load_relaxed(&bottom_);
+    long t = atomic_load_acquire(&top_);
+    ring* r = atomic_load_relaxed(&ring_);
+    if (b - t > r->mask) r = grow(r, t, b);
+    atomic_store_relaxed(&r->slots[b & r->mask], val);
+    atomic_store_release(&bottom_, b + 1);
+  }
+
+  // Owner only. Takes the most recently pushed element; returns 0 if the
+  // deque is empty.
+  int pop(value_type& val) {
+    long b = atomic_load_relaxed(&bottom_) - 1;
+    ring* r = atomic_load_relaxed(&ring_);
+    atomic_store_relaxed(&bottom_, b);
+    // Claiming the bottom slot must be visible before top is read, or a
+    // thief could take the same element.
+    atomic_fence();
+    long t = atomic_load_relaxed(&top_);
+    if (t > b) {
+      atomic_store_relaxed(&bottom_, b + 1);
+      return 0;
+    }
+    val = atomic_load_relaxed(&r->slots[b & r->mask]);
+    if (t == b) {
+      // The last element: race the thieves for it through top.
+      int won = atomic_compare_exchange(&top_, t, t + 1);
+      atomic_store_relaxed(&bottom_, b + 1);
+      return won;
+    }
+    return 1;
+  }
+
+  // Any thread. Takes the oldest element; returns 0 if the deque is empty or
+  // another thread got there first, in which case trying elsewhere is best.
+  int steal(value_type& val) {
+    long t = atomic_load_acquire(&top_);
+    atomic_fence();
+    long b = atomic_load_acquire(&bottom_);
+    if (t >= b) return 0;
+    ring* r = atomic_load_acquire(&ring_);
+    value_type x = atomic_load_relaxed(&r->slots[t & r->mask]);
+    if (!atomic_compare_exchange(&top_, t, t + 1)) return 0;
+    val = x;
+    return 1;
+  }
+
+ private:
+  // A power-of-two buffer, indexed by position & mask. Outgrown buffers are
+  // kept on the retired list until the deque dies, since a thief may still
+  // be reading one.
+  struct ring {
+    long mask;
+    value_type* slots;
+    ring* retired;
+  };
+
+  // top_ only grows, by successful steals and by pop() taking the last
+  // element; bottom_ moves with push() and pop().
+  volatile long top_;
+  volatile long bottom_;
+  ring* volatile ring_;
+
+  static ring* new_ring(long cap, ring* retired) {
+    ring* r = new ring;
+    r->mask = cap - 1;
+    r->slots = _allocate((unsigned)cap, (value_type*)0);
+    r->retired = retired;
+    return r;
+  }
+
+  ring* grow(ring* old, long t, long b) {
+    ring* r = new_ring(2 * (old->mask + 1), old);
+    for (long i = t; i < b; i++)
+      atomic_store_relaxed(&r->slots[i & r->mask],
+                           atomic_load_relaxed(&old->slots[i & old->mask]));
+    atomic_store_release(&ring_, r);
+    return r;
+  }
+
+  work_stealing_deque(const work_stealing_deque&);
+  work_stealing_deque& operator=(const work_stealing_deque&);
+};
+
+class work_stealing_scheduler;
+
+// A unit of work. run() may spawn more tasks on the worker it runs on.
+class ws_task {
+ public:
+  virtual ~ws_task() {}
+
+  virtual void run(work_stealing_scheduler& sched, int worker) = 0;
+};
+
+// The scheduling loop of a work-stealing runtime, without the threads: the
+// caller starts one thread per worker and has each call run_worker() with its
+// own number. Workers run their own tasks newest first and, when out of
+// work, steal the oldest task of another worker. All of them return once
+// every spawned task has finished. Idle workers spin; a kernel would halt
+// or yield there instead.
+class work_stealing_scheduler {
+ public:
+  work_stealing_scheduler(int workers)
+      : deques_(new work_stealing_deque<ws_task*>[workers]),
+        workers_(workers),
+        pending_(0) {
+    assert(workers > 0);
+  }
+
+  ~work_stealing_scheduler() { delete[] deques_; }
+
+  int workers() const { return workers_; }
+
+  // Queues task on worker's deque. Only worker's own thread may call this,
+  // or any thread before the workers start.
+  void spawn(int worker, ws_task* task) {
+    atomic_fetch_add(&pending_, 1L);
+    deques_[worker].push(task);
+  }
+
+  void run_worker(int self) {
+    unsigned victim = self;
+    while (atomic_load_acquire(&pending_) > 0) {
+      ws_task* task;
+      if (!deques_[self].pop(task) && !steal(self, victim, task)) continue;
+      task->run(*this, self);
+      atomic_fetch_add(&pending_, -1L);
+    }
+  }
+
+ private:
+  work_stealing_deque<ws_task*>* deques_;
+  int workers_;
+  // Tasks spawned and not yet finished.
+  volatile long pending_;
+
+  // One round over the other workers, starting after the last one robbed.
+  int steal(int self, unsigned& victim, ws_task*& task) {
+    for (int i = 1; i < workers_; i++) {
+      victim = (victim + 1) % workers_;
+      if ((int)victim != self && deques_[victim].steal(task)) return 1;
+    }
+    return 0;
+  }
+
+  work_stealing_scheduler(const work_stealing_scheduler&);
+  work_stealing_scheduler& operator=(const work_stealing_scheduler&);
+};
+
+#endif  // _STL_WORK_STEALING_DEQUE_H_